@@ -0,0 +1,75 @@
+#include "AllPairsTable.h"
+#include "MemoryReport.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+AllPairsTable AllPairsTable::build(const GraphSnapshot& network, unsigned threads) {
+    TraceSpan span("buildAllPairs", "locations", network.nodeCount());
+    AllPairsTable table;
+    uint32_t n = network.nodeCount();
+    if (n == 0 || n > MAX_NODES) return table;
+    table.nodes = n;
+    table.distances.resize(2 * size_t(n) * n);
+    table.predecessors.resize(2 * size_t(n) * n);
+
+    // distancesFrom keeps no state between calls, so the threads share one search
+    ArraySearch<GraphSnapshot> search(network);
+    std::atomic<uint32_t> nextRow{0};
+    auto work = [&] {
+        std::vector<int> distances;
+        std::vector<uint32_t> parents;
+        for (uint32_t row; (row = nextRow.fetch_add(1, std::memory_order_relaxed)) < 2 * n;) {
+            bool isDriving = row < n;
+            uint32_t source = row % n;
+            search.distancesFrom(source, isDriving, distances, &parents);
+            size_t offset = table.row(isDriving, source);
+            std::copy(distances.begin(), distances.end(), table.distances.begin() + offset);
+            std::copy(parents.begin(), parents.end(), table.predecessors.begin() + offset);
+        }
+    };
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, 2 * n);
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work);
+    work();
+    for (auto& worker : workers) worker.join();
+    return table;
+}
+
+std::pair<std::vector<int>, int> AllPairsTable::route(const GraphSnapshot& network, bool isDriving, uint32_t source,
+                                                      uint32_t destination,
+                                                      std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) const {
+    int total = distance(isDriving, source, destination);
+    if (total == INF) return {};
+    const uint16_t* parents = predecessors.data() + row(isDriving, source);
+    std::vector<int> path;
+    uint32_t node = destination;
+    path.push_back(network.nodeId(node));
+    while (node != source) {
+        uint32_t previous = parents[node];
+        blockedSegments.insert({network.nodeId(previous), network.nodeId(node)});
+        node = previous;
+        path.push_back(network.nodeId(node));
+    }
+    std::reverse(path.begin(), path.end());
+    return {path, total};
+}
+
+void AllPairsTable::reportMemory(MemoryReport& report) const {
+    report.add("all-pairs", "distances", MemoryReport::vectorBytes(distances));
+    report.add("all-pairs", "predecessors", MemoryReport::vectorBytes(predecessors));
+}
+
+std::pair<std::vector<int>, int> AllPairsEngine::findPath(
+    int sourceId, int destinationId, bool isDriving,
+    const std::unordered_set<int>& blockedNodes,
+    std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) {
+    int source = network.indexOf(sourceId), destination = network.indexOf(destinationId);
+    if (!blockedNodes.empty() || !blockedSegments.empty() || source < 0 || destination < 0) {
+        return engine->findPath(sourceId, destinationId, isDriving, blockedNodes, blockedSegments);
+    }
+    return table.route(network, isDriving, static_cast<uint32_t>(source), static_cast<uint32_t>(destination),
+                       blockedSegments);
+}
@@ -0,0 +1,107 @@
+/**
+* @file AllPairsTable.h
+ * @brief Precomputed distance and predecessor matrices for small road networks
+ */
+
+#ifndef ALL_PAIRS_TABLE_H
+#define ALL_PAIRS_TABLE_H
+
+#include "GraphSnapshot.h"
+#include "SearchEngine.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class MemoryReport;
+
+/**
+ * @class AllPairsTable
+ * @brief Shortest distance and path between every two locations, per travel mode
+ * @details Row s of a mode holds the distance from location s to every location and
+ * each location's predecessor on the shortest path tree of s, as Dijkstra on the snapshot
+ * builds it. A route is read by following the predecessors back from the destination, so
+ * it is the one SnapshotEngine finds, in time proportional to its length.
+ *
+ * The rows are independent searches, built in parallel. Predecessors are 16-bit indexes,
+ * so the table holds at most MAX_NODES locations and takes 12 bytes per pair of locations.
+ */
+class AllPairsTable {
+public:
+    static constexpr uint32_t MAX_NODES = 1 << 16;   ///< Locations a table can index
+
+    AllPairsTable() = default;
+    AllPairsTable(const AllPairsTable&) = delete;
+    AllPairsTable& operator=(const AllPairsTable&) = delete;
+    AllPairsTable(AllPairsTable&&) = default;
+    AllPairsTable& operator=(AllPairsTable&&) = default;
+
+    /**
+     * @brief Runs one unrestricted Dijkstra per location and mode.
+     * @param network A network of at most MAX_NODES locations.
+     * @param threads Number of threads, 0 for one per hardware thread.
+     * @complexity O(N (N + M) log N) work where N is the number of locations and M is the number of roads.
+     */
+    static AllPairsTable build(const GraphSnapshot& network, unsigned threads = 0);
+
+    uint32_t nodeCount() const { return nodes; }
+
+    /**
+     * @brief Unrestricted travel time between two locations, INF if unreachable.
+     * @complexity O(1).
+     */
+    int distance(bool isDriving, uint32_t source, uint32_t destination) const {
+        return distances[row(isDriving, source) + destination];
+    }
+
+    /**
+     * @brief Returns the route between two locations with the contract of SearchEngine::findPath.
+     * @complexity O(L) where L is the number of locations on the route.
+     */
+    std::pair<std::vector<int>, int> route(const GraphSnapshot& network, bool isDriving, uint32_t source,
+                                           uint32_t destination,
+                                           std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) const;
+
+    /**
+     * @brief Adds the distance and predecessor matrices to a memory report.
+     */
+    void reportMemory(MemoryReport& report) const;
+
+    size_t bytes() const { return distances.size() * sizeof(int32_t) + predecessors.size() * sizeof(uint16_t); }
+
+private:
+    size_t row(bool isDriving, uint32_t source) const { return (size_t(isDriving ? 0 : nodes) + source) * nodes; }
+
+    uint32_t nodes = 0;
+    std::vector<int32_t> distances;       ///< Driving rows, then walking rows
+    std::vector<uint16_t> predecessors;   ///< Same layout; the source is its own predecessor
+};
+
+/**
+ * @class AllPairsEngine
+ * @brief Answers unrestricted searches from an AllPairsTable and forwards the others to an engine
+ * @details Searches avoiding locations or roads, including the alternative route search,
+ * go to the wrapped engine. The multimodal planner runs through the base SearchEngine
+ * implementation, so every driving and walking leg it tries is a table lookup.
+ */
+class AllPairsEngine : public SearchEngine {
+public:
+    AllPairsEngine(std::unique_ptr<SearchEngine> engine, const GraphSnapshot& network, const AllPairsTable& table)
+        : engine(std::move(engine)), network(network), table(table) {}
+
+    const char* name() const override { return "all-pairs"; }
+    std::pair<std::vector<int>, int> findPath(
+        int sourceId, int destinationId, bool isDriving,
+        const std::unordered_set<int>& blockedNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) override;
+    bool hasLocation(int id) const override { return engine->hasLocation(id); }
+    const std::vector<int>& parkingLocations() override { return engine->parkingLocations(); }
+    void reportMemory(MemoryReport& report) const override { engine->reportMemory(report); }
+
+private:
+    std::unique_ptr<SearchEngine> engine;
+    const GraphSnapshot& network;
+    const AllPairsTable& table;
+};
+
+#endif // ALL_PAIRS_TABLE_H
@@ -0,0 +1,181 @@
+/**
+* @file ArraySearch.h
+ * @brief Shortest-path search over array-based road networks
+ */
+
+#ifndef ARRAY_SEARCH_H
+#define ARRAY_SEARCH_H
+
+#include "Graph.h"
+#include "MemoryReport.h"
+#include "PerfCounters.h"
+#include "SearchStats.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ArraySearch
+ * @brief Dijkstra / A* over any network addressed by dense node index
+ * @details Network must provide nodeCount(), nodeId(node), indexOf(id) and
+ * forEachEdge(node, isDriving, visit) calling visit(target, weight) for every road.
+ * Results follow Graph::dijkstra exactly: blocked locations are reached but never
+ * expanded, roads with an INF weight are skipped, and the segments of the returned
+ * path are added to blockedSegments so a second call yields an alternative route.
+ *
+ * The distance and parent arrays are kept between calls and reset lazily with a
+ * generation counter, so a query only touches the nodes it reaches.
+ */
+template <typename Network>
+class ArraySearch {
+public:
+    explicit ArraySearch(const Network& network)
+        : network(network), dist(network.nodeCount()), parent(network.nodeCount()), stamp(network.nodeCount(), 0) {}
+
+    /**
+     * @brief Plain Dijkstra, with the same contract as Graph::dijkstra.
+     * @complexity O((N + M) log N) where N is the number of locations and M is the number of Roads.
+     */
+    std::pair<std::vector<int>, int> run(int sourceId, int destinationId, bool isDriving,
+                                         const std::unordered_set<int>& blockedNodes,
+                                         std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) {
+        return run(sourceId, destinationId, isDriving, blockedNodes, blockedSegments,
+                   [](uint32_t) { return 0; });
+    }
+
+    /**
+     * @brief A* guided by a consistent lower bound on the remaining distance.
+     * @param lowerBound Callable returning a lower bound of the distance from a node to the destination.
+     */
+    template <typename LowerBound>
+    std::pair<std::vector<int>, int> run(int sourceId, int destinationId, bool isDriving,
+                                         const std::unordered_set<int>& blockedNodes,
+                                         std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments,
+                                         LowerBound lowerBound) {
+        TraceSpan span("dijkstra", "source", sourceId, "destination", destinationId);
+        PerfPhase phase(PerfProfile::Initialisation);
+        int sourceIndex = network.indexOf(sourceId);
+        int destIndex = network.indexOf(destinationId);
+        if (sourceIndex < 0 || destIndex < 0) return {};
+        auto source = static_cast<uint32_t>(sourceIndex), destination = static_cast<uint32_t>(destIndex);
+
+        if (++generation == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        std::priority_queue<std::pair<int, uint32_t>, std::vector<std::pair<int, uint32_t>>, std::greater<>> pq;
+        reach(source, 0, source);
+        pq.emplace(lowerBound(source), source);
+        SEARCH_STAT(pushes);
+
+        phase.next(PerfProfile::Search);
+        while (!pq.empty()) {
+            auto [key, node] = pq.top();
+            pq.pop();
+            SEARCH_STAT(pops);
+            int nodeDist = dist[node];
+            if (key > nodeDist + lowerBound(node)) {
+                SEARCH_STAT(stalePops);
+                continue;
+            }
+            if (node == destination) break;
+            if (!blockedNodes.empty() && blockedNodes.count(network.nodeId(node))) {
+                SEARCH_STAT(blockedSkips);
+                continue;
+            }
+            SEARCH_STAT(settled);
+
+            int nodeId = network.nodeId(node);
+            network.forEachEdge(node, isDriving, [&](uint32_t next, int weight) {
+                if (weight == INF) return;
+                if (!blockedSegments.empty() && blockedSegments.count({nodeId, network.nodeId(next)})) {
+                    SEARCH_STAT(blockedSkips);
+                    return;
+                }
+                SEARCH_STAT(relaxed);
+                int newDist = nodeDist + weight;
+                if (newDist < distance(next)) {
+                    reach(next, newDist, node);
+                    pq.emplace(newDist + lowerBound(next), next);
+                    SEARCH_STAT(pushes);
+                }
+            });
+        }
+
+        phase.next(PerfProfile::PathReconstruction);
+        int total = distance(destination);
+        if (total == INF) return {};
+        std::vector<int> path;
+        uint32_t node = destination;
+        path.push_back(network.nodeId(node));
+        while (node != source) {
+            uint32_t previous = parent[node];
+            blockedSegments.insert({network.nodeId(previous), network.nodeId(node)});
+            node = previous;
+            path.push_back(network.nodeId(node));
+        }
+        std::reverse(path.begin(), path.end());
+        return {path, total};
+    }
+
+    /**
+     * @brief Computes the unrestricted distance from source to every node.
+     * @param distances Resized to nodeCount(); INF for nodes that cannot be reached.
+     * @param parents If not null, resized to nodeCount() and filled with each node's
+     * predecessor on the shortest path tree (the node itself for the source and unreached nodes).
+     * @complexity O((N + M) log N) where N is the number of locations and M is the number of Roads.
+     */
+    void distancesFrom(uint32_t source, bool isDriving, std::vector<int>& distances,
+                       std::vector<uint32_t>* parents = nullptr) const {
+        distances.assign(network.nodeCount(), INF);
+        if (parents) {
+            parents->resize(network.nodeCount());
+            for (uint32_t node = 0; node < parents->size(); ++node) (*parents)[node] = node;
+        }
+        std::priority_queue<std::pair<int, uint32_t>, std::vector<std::pair<int, uint32_t>>, std::greater<>> pq;
+        distances[source] = 0;
+        pq.emplace(0, source);
+        while (!pq.empty()) {
+            auto [nodeDist, node] = pq.top();
+            pq.pop();
+            if (nodeDist > distances[node]) continue;
+            network.forEachEdge(node, isDriving, [&](uint32_t next, int weight) {
+                if (weight == INF) return;
+                int newDist = nodeDist + weight;
+                if (newDist < distances[next]) {
+                    distances[next] = newDist;
+                    if (parents) (*parents)[next] = node;
+                    pq.emplace(newDist, next);
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Heap bytes of the distance, parent and generation arrays.
+     */
+    size_t workspaceBytes() const {
+        return MemoryReport::vectorBytes(dist) + MemoryReport::vectorBytes(parent) + MemoryReport::vectorBytes(stamp);
+    }
+
+private:
+    int distance(uint32_t node) const { return stamp[node] == generation ? dist[node] : INF; }
+
+    void reach(uint32_t node, int newDist, uint32_t from) {
+        dist[node] = newDist;
+        parent[node] = from;
+        stamp[node] = generation;
+    }
+
+    const Network& network;
+    std::vector<int> dist;          ///< Tentative distance, valid when stamp matches generation
+    std::vector<uint32_t> parent;   ///< Predecessor on the shortest path tree
+    std::vector<uint32_t> stamp;    ///< Generation in which dist/parent were last written
+    uint32_t generation = 0;        ///< Current query generation
+};
+
+#endif // ARRAY_SEARCH_H
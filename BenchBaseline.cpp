@@ -0,0 +1,158 @@
+#include "BenchBaseline.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+namespace {
+
+const char* const HEADER = "generator,nodes,parking,seed,queries,workload,engine,p50_ms,p99_ms,run_means_ms";
+
+/**
+ * @brief Two-sided 95% critical value of Student's t distribution.
+ */
+double tCritical95(double degreesOfFreedom) {
+    static const double TABLE[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degreesOfFreedom < 1) return TABLE[0];
+    if (degreesOfFreedom <= 30) return TABLE[static_cast<int>(degreesOfFreedom) - 1];
+    return 1.960 + (TABLE[29] - 1.960) * 30.0 / degreesOfFreedom;
+}
+
+vector<string> splitFields(const string& line, char separator) {
+    vector<string> fields;
+    stringstream stream(line);
+    string field;
+    while (getline(stream, field, separator)) fields.push_back(field);
+    return fields;
+}
+
+} // namespace
+
+string BenchResult::key() const {
+    return generator + ',' + to_string(nodes) + ',' + parking + ',' + to_string(seed) + ',' + to_string(queries) + ','
+           + workload + ',' + engine;
+}
+
+double BenchResult::mean() const {
+    double sum = 0;
+    for (double value : runMeans) sum += value;
+    return runMeans.empty() ? 0 : sum / double(runMeans.size());
+}
+
+double BenchResult::stddev() const {
+    if (runMeans.size() < 2) return 0;
+    double average = mean(), squares = 0;
+    for (double value : runMeans) squares += (value - average) * (value - average);
+    return sqrt(squares / double(runMeans.size() - 1));
+}
+
+double BenchResult::confidence95() const {
+    if (runMeans.size() < 2) return 0;
+    return tCritical95(double(runMeans.size() - 1)) * stddev() / sqrt(double(runMeans.size()));
+}
+
+bool BenchBaseline::load(const string& filename, vector<BenchResult>& results) {
+    ifstream file(filename);
+    if (!file) {
+        cerr << "Error: Unable to open " << filename << endl;
+        return false;
+    }
+    string line;
+    getline(file, line); // Header
+    for (size_t lineNumber = 2; getline(file, line); ++lineNumber) {
+        if (line.empty()) continue;
+        vector<string> fields = splitFields(line, ',');
+        BenchResult result;
+        try {
+            if (fields.size() != 10) throw invalid_argument("field count");
+            result.generator = fields[0];
+            result.nodes = static_cast<uint32_t>(stoul(fields[1]));
+            result.parking = fields[2];
+            result.seed = stoull(fields[3]);
+            result.queries = static_cast<uint32_t>(stoul(fields[4]));
+            result.workload = fields[5];
+            result.engine = fields[6];
+            result.p50 = stod(fields[7]);
+            result.p99 = stod(fields[8]);
+            for (const string& value : splitFields(fields[9], ';')) result.runMeans.push_back(stod(value));
+        } catch (const exception&) {
+            cerr << "Error: " << filename << ":" << lineNumber << ": malformed baseline row" << endl;
+            return false;
+        }
+        results.push_back(std::move(result));
+    }
+    return true;
+}
+
+bool BenchBaseline::save(const string& filename, const vector<BenchResult>& results) {
+    vector<BenchResult> rows;
+    if (ifstream(filename).good() && !load(filename, rows)) return false;
+    for (const BenchResult& result : results) {
+        auto existing = find_if(rows.begin(), rows.end(), [&](const BenchResult& row) { return row.key() == result.key(); });
+        if (existing != rows.end()) *existing = result;
+        else rows.push_back(result);
+    }
+    ofstream file(filename);
+    if (!file) {
+        cerr << "Error: Unable to open " << filename << endl;
+        return false;
+    }
+    file << HEADER << '\n' << setprecision(9);
+    for (const BenchResult& row : rows) {
+        file << row.key() << ',' << row.p50 << ',' << row.p99 << ',';
+        for (size_t i = 0; i < row.runMeans.size(); ++i) file << (i ? ";" : "") << row.runMeans[i];
+        file << '\n';
+    }
+    return static_cast<bool>(file.flush());
+}
+
+bool BenchBaseline::compare(const vector<BenchResult>& baseline, const vector<BenchResult>& current,
+                            double threshold, ostream& out) {
+    bool passed = true;
+    ios::fmtflags flags = out.flags();
+    out << left << setw(12) << "workload" << setw(12) << "engine" << right << setw(14) << "base (ms)"
+        << setw(14) << "now (ms)" << setw(10) << "change" << setw(22) << "95% CI of change" << "  verdict" << '\n';
+    out << fixed;
+    for (const BenchResult& now : current) {
+        out << left << setw(12) << now.workload << setw(12) << now.engine << right;
+        auto base = find_if(baseline.begin(), baseline.end(), [&](const BenchResult& row) { return row.key() == now.key(); });
+        if (base == baseline.end() || base->mean() <= 0) {
+            out << setw(14) << "-" << setw(14) << setprecision(3) << now.mean() << setw(10) << "-" << setw(22) << "-"
+                << "  new" << '\n';
+            continue;
+        }
+        double baseMean = base->mean(), nowMean = now.mean();
+        double change = nowMean / baseMean - 1;
+        out << setw(14) << setprecision(3) << baseMean << setw(14) << nowMean << setw(9) << setprecision(1)
+            << 100 * change << '%';
+
+        // Welch's t-test: unequal variances and run counts
+        size_t n1 = base->runMeans.size(), n2 = now.runMeans.size();
+        bool slower, faster;
+        if (n1 >= 2 && n2 >= 2) {
+            double v1 = base->stddev() * base->stddev() / double(n1), v2 = now.stddev() * now.stddev() / double(n2);
+            double se = sqrt(v1 + v2);
+            double df = se > 0 ? pow(v1 + v2, 2) / (v1 * v1 / double(n1 - 1) + v2 * v2 / double(n2 - 1)) : 1e9;
+            double margin = tCritical95(df) * se;
+            double low = (nowMean - baseMean - margin) / baseMean, high = (nowMean - baseMean + margin) / baseMean;
+            ostringstream interval;
+            interval << fixed << setprecision(1) << '[' << 100 * low << "%, " << 100 * high << "%]";
+            out << setw(22) << interval.str();
+            slower = change > threshold && low > 0;
+            faster = change < -threshold && high < 0;
+        } else {
+            out << setw(22) << "single run";
+            slower = change > threshold;
+            faster = change < -threshold;
+        }
+        out << (slower ? "  REGRESSION" : faster ? "  faster" : "  ok") << '\n';
+        if (slower) passed = false;
+    }
+    out.flags(flags);
+    return passed;
+}
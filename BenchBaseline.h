@@ -0,0 +1,76 @@
+/**
+* @file BenchBaseline.h
+ * @brief Stored benchmark results and the statistical regression check against them
+ */
+
+#ifndef BENCH_BASELINE_H
+#define BENCH_BASELINE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @struct BenchResult
+ * @brief Repeated runs of one workload on one engine and one generated graph
+ */
+struct BenchResult {
+    std::string generator;
+    uint32_t nodes = 0;
+    std::string parking;            ///< Parking density as given on the command line
+    uint64_t seed = 0;
+    uint32_t queries = 0;           ///< Queries option; with the seed it fixes the workload
+    std::string workload;
+    std::string engine;
+    std::vector<double> runMeans;   ///< Mean query latency of each run, in ms
+    double p50 = 0;                 ///< Latency percentiles over all runs, in ms
+    double p99 = 0;
+
+    /**
+     * @brief Identifies the graph, workload and engine; only equal keys are compared.
+     */
+    std::string key() const;
+
+    double mean() const;
+    double stddev() const;
+
+    /**
+     * @brief Half-width of the 95% confidence interval of the mean; 0 for a single run.
+     */
+    double confidence95() const;
+};
+
+/**
+ * @class BenchBaseline
+ * @brief Reads, writes and compares benchmark baselines
+ * @details A baseline is a CSV file with one row per graph, workload and engine,
+ * holding the mean latency of every run so later comparisons can use the spread.
+ */
+class BenchBaseline {
+public:
+    /**
+     * @brief Reads a baseline file.
+     * @return False if it cannot be opened or is malformed; the reason is printed on cerr.
+     */
+    static bool load(const std::string& filename, std::vector<BenchResult>& results);
+
+    /**
+     * @brief Writes results to a baseline file, keeping its rows for other graphs, workloads or engines.
+     * @return False if the file cannot be written.
+     */
+    static bool save(const std::string& filename, const std::vector<BenchResult>& results);
+
+    /**
+     * @brief Compares current results with a baseline using Welch's t-test on the run means.
+     * @details A result regresses when its mean latency is more than threshold slower and
+     * the 95% confidence interval of the difference lies entirely above zero. With a
+     * single run on either side there is no interval and only the threshold applies.
+     * @param threshold Tolerated relative slowdown, e.g. 0.1 for 10%.
+     * @return False if any result regressed.
+     */
+    static bool compare(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& current,
+                        double threshold, std::ostream& out);
+};
+
+#endif // BENCH_BASELINE_H
@@ -0,0 +1,122 @@
+#include "CompressedGraph.h"
+#include "MemoryReport.h"
+#include "Trace.h"
+#include <algorithm>
+
+namespace {
+
+void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+
+/**
+ * @brief Collects the distinct values of one road time array, if there are at most 256.
+ * @return The sorted distinct values, or an empty vector if they do not fit a byte code.
+ */
+std::vector<int32_t> buildDictionary(const GraphSnapshot& graph, bool isDriving) {
+    std::vector<int32_t> values;
+    for (uint32_t e = 0; e < graph.edgeCount(); ++e) {
+        values.push_back(isDriving ? graph.drivingTime(e) : graph.walkingTime(e));
+        if (values.size() > 4096) {
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+            if (values.size() > 256) return {};
+        }
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    if (values.size() > 256) return {};
+    return values;
+}
+
+void writeWeight(std::vector<uint8_t>& out, const std::vector<int32_t>& dictionary, int weight) {
+    if (!dictionary.empty()) {
+        out.push_back(static_cast<uint8_t>(std::lower_bound(dictionary.begin(), dictionary.end(), weight) - dictionary.begin()));
+    } else {
+        writeVarint(out, weight == INF ? 0 : static_cast<uint64_t>(weight) + 1);
+    }
+}
+
+} // namespace
+
+CompressedGraph CompressedGraph::build(const GraphSnapshot& graph) {
+    TraceSpan span("buildCompressed");
+    uint32_t nodeCount = graph.nodeCount();
+
+    std::vector<uint32_t> order = GraphSnapshot::breadthFirstOrder(graph);
+    std::vector<uint32_t> rank(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) rank[order[i]] = i;
+
+    CompressedGraph compressed;
+    compressed.edges = graph.edgeCount();
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        if (graph.hasParking(node)) compressed.parking.push_back(graph.nodeId(node));
+    }
+    compressed.drivingDictionary = buildDictionary(graph, true);
+    compressed.walkingDictionary = buildDictionary(graph, false);
+    compressed.ids.resize(nodeCount);
+    compressed.idIndex.resize(nodeCount);
+    compressed.offsets.resize(size_t(nodeCount) + 1);
+    compressed.stream.reserve(graph.edgeCount() * 4);
+
+    std::vector<CompressedEdge> roads;
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        uint32_t original = order[node];
+        compressed.ids[node] = graph.nodeId(original);
+        compressed.idIndex[node] = {graph.nodeId(original), node};
+        compressed.offsets[node] = compressed.stream.size();
+
+        roads.clear();
+        for (uint32_t e = graph.edgesBegin(original); e < graph.edgesEnd(original); ++e) {
+            roads.push_back({rank[graph.target(e)], graph.drivingTime(e), graph.walkingTime(e)});
+        }
+        std::stable_sort(roads.begin(), roads.end(),
+                         [](const CompressedEdge& a, const CompressedEdge& b) { return a.target < b.target; });
+        uint32_t previous = 0;
+        for (size_t i = 0; i < roads.size(); ++i) {
+            if (i == 0) writeVarint(compressed.stream, zigzag(int64_t(roads[i].target) - int64_t(node)));
+            else writeVarint(compressed.stream, roads[i].target - previous);
+            previous = roads[i].target;
+            writeWeight(compressed.stream, compressed.drivingDictionary, roads[i].drivingTime);
+            writeWeight(compressed.stream, compressed.walkingDictionary, roads[i].walkingTime);
+        }
+    }
+    compressed.offsets[nodeCount] = compressed.stream.size();
+    compressed.stream.shrink_to_fit();
+    // Stable, so duplicated IDs resolve to the first location as in Graph::findLocation
+    std::stable_sort(compressed.idIndex.begin(), compressed.idIndex.end(),
+                     [&](const SnapshotIdEntry& a, const SnapshotIdEntry& b) {
+                         return a.id < b.id || (a.id == b.id && order[a.index] < order[b.index]);
+                     });
+    return compressed;
+}
+
+int CompressedGraph::indexOf(int id) const {
+    auto it = std::lower_bound(idIndex.begin(), idIndex.end(), id,
+        [](const SnapshotIdEntry& entry, int value) { return entry.id < value; });
+    return it != idIndex.end() && it->id == id ? static_cast<int>(it->index) : -1;
+}
+
+size_t CompressedGraph::adjacencyBytes() const {
+    return stream.size() + offsets.size() * sizeof(uint64_t)
+           + (drivingDictionary.size() + walkingDictionary.size()) * sizeof(int32_t);
+}
+
+size_t CompressedGraph::byteSize() const {
+    return adjacencyBytes() + ids.size() * sizeof(int32_t) + idIndex.size() * sizeof(SnapshotIdEntry)
+           + parking.size() * sizeof(int);
+}
+
+void CompressedGraph::reportMemory(MemoryReport& report) const {
+    report.add("compressed", "adjacency", MemoryReport::vectorBytes(stream) + MemoryReport::vectorBytes(offsets));
+    report.add("compressed", "dictionaries", MemoryReport::vectorBytes(drivingDictionary)
+                                             + MemoryReport::vectorBytes(walkingDictionary));
+    report.add("compressed", "id index", MemoryReport::vectorBytes(ids) + MemoryReport::vectorBytes(idIndex));
+    report.add("compressed", "parking", MemoryReport::vectorBytes(parking));
+}
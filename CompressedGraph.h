@@ -0,0 +1,154 @@
+/**
+* @file CompressedGraph.h
+ * @brief Compressed, locality-ordered adjacency encoding for very large road networks
+ */
+
+#ifndef COMPRESSED_GRAPH_H
+#define COMPRESSED_GRAPH_H
+
+#include "GraphSnapshot.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct CompressedEdge
+ * @brief One decoded road
+ */
+struct CompressedEdge {
+    uint32_t target;   ///< Destination, as a CompressedGraph node index
+    int drivingTime;   ///< Driving time, INF if not drivable
+    int walkingTime;   ///< Walking time
+};
+
+/**
+ * @class CompressedGraph
+ * @brief Road network stored as a varint byte stream, renumbered for locality
+ * @details Locations are renumbered in breadth-first order so that neighbours get close
+ * indexes. Each location's roads are sorted by target and stored as a byte stream:
+ * the first target as a zigzag varint relative to the location, the following ones as
+ * varint gaps to the previous target. Road times are replaced by a one-byte code into a
+ * per-mode dictionary when a mode has at most 256 distinct times, and stored as varints
+ * otherwise. Node indexes differ from the snapshot's; IDs are preserved.
+ */
+class CompressedGraph {
+public:
+    /**
+     * @class EdgeIterator
+     * @brief Decodes the roads of one location in order
+     */
+    class EdgeIterator {
+    public:
+        /**
+         * @brief Decodes the next road.
+         * @return False once every road has been read.
+         */
+        bool next(CompressedEdge& edge) {
+            if (position == end) return false;
+            uint64_t value = readVarint();
+            edge.target = first ? static_cast<uint32_t>(int64_t(source) + unzigzag(value))
+                                : previous + static_cast<uint32_t>(value);
+            first = false;
+            previous = edge.target;
+            edge.drivingTime = readWeight(graph->drivingDictionary);
+            edge.walkingTime = readWeight(graph->walkingDictionary);
+            return true;
+        }
+
+    private:
+        friend class CompressedGraph;
+        EdgeIterator(const CompressedGraph* graph, uint32_t source, const uint8_t* position, const uint8_t* end)
+            : graph(graph), source(source), position(position), end(end) {}
+
+        uint64_t readVarint() {
+            uint64_t value = 0;
+            for (unsigned shift = 0;; shift += 7) {
+                uint8_t byte = *position++;
+                value |= uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+        }
+
+        int readWeight(const std::vector<int32_t>& dictionary) {
+            if (!dictionary.empty()) return dictionary[*position++];
+            uint64_t value = readVarint();
+            return value == 0 ? INF : static_cast<int>(value - 1);
+        }
+
+        static int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+        const CompressedGraph* graph;
+        uint32_t source;
+        const uint8_t* position;
+        const uint8_t* end;
+        uint32_t previous = 0;
+        bool first = true;
+    };
+
+    /**
+     * @brief Renumbers and encodes a snapshot.
+     * @complexity O(N + M log D) where D is the largest number of roads of a location.
+     */
+    static CompressedGraph build(const GraphSnapshot& graph);
+
+    uint32_t nodeCount() const { return static_cast<uint32_t>(ids.size()); }
+    size_t edgeCount() const { return edges; }
+    int nodeId(uint32_t node) const { return ids[node]; }
+
+    /**
+     * @brief Finds the node index of a location by ID.
+     * @return The index, or -1 if there is no such location.
+     * @complexity O(log N) where N is the number of locations.
+     */
+    int indexOf(int id) const;
+
+    /**
+     * @brief IDs of the locations with parking, in the order of the source snapshot.
+     */
+    const std::vector<int>& parkingLocations() const { return parking; }
+
+    /**
+     * @brief Iterator over the roads of a location.
+     */
+    EdgeIterator edgesOf(uint32_t node) const {
+        return {this, node, stream.data() + offsets[node], stream.data() + offsets[node + 1]};
+    }
+
+    /**
+     * @brief Calls visit(target, weight) for every road leaving node.
+     * @param isDriving Selects driving times instead of walking times.
+     */
+    template <typename Visit>
+    void forEachEdge(uint32_t node, bool isDriving, Visit visit) const {
+        EdgeIterator it = edgesOf(node);
+        CompressedEdge edge{};
+        while (it.next(edge)) visit(edge.target, isDriving ? edge.drivingTime : edge.walkingTime);
+    }
+
+    /**
+     * @brief Memory used by the adjacency encoding (stream, offsets and dictionaries).
+     */
+    size_t adjacencyBytes() const;
+
+    /**
+     * @brief Total memory used, including the ID tables.
+     */
+    size_t byteSize() const;
+
+    /**
+     * @brief Adds the adjacency stream, dictionaries and ID tables to a memory report.
+     */
+    void reportMemory(MemoryReport& report) const;
+
+private:
+    std::vector<uint8_t> stream;              ///< Encoded roads of every location, in node order
+    std::vector<uint64_t> offsets;            ///< Start of each location's roads in stream, plus the end
+    std::vector<int32_t> ids;                 ///< Location ID of each node
+    std::vector<SnapshotIdEntry> idIndex;     ///< (ID, node) pairs sorted by ID
+    std::vector<int> parking;                 ///< IDs of the locations with parking
+    std::vector<int32_t> drivingDictionary;   ///< Distinct driving times, empty if stored as varints
+    std::vector<int32_t> walkingDictionary;   ///< Distinct walking times, empty if stored as varints
+    size_t edges = 0;                         ///< Number of directed roads
+};
+
+#endif // COMPRESSED_GRAPH_H
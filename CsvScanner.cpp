@@ -0,0 +1,92 @@
+#include "CsvScanner.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CSV_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using ScanFunction = size_t (*)(const char*, size_t, uint32_t*);
+
+/**
+ * @brief Byte-at-a-time scan of text[begin, length), appending to indexes[count..].
+ */
+inline size_t scanTail(const char* text, size_t begin, size_t length, uint32_t* indexes, size_t count) {
+    for (size_t i = begin; i < length; ++i) {
+        if (text[i] == ',' || text[i] == '\n') indexes[count++] = static_cast<uint32_t>(i);
+    }
+    return count;
+}
+
+size_t scanScalar(const char* text, size_t length, uint32_t* indexes) {
+    return scanTail(text, 0, length, indexes, 0);
+}
+
+#ifdef CSV_SCANNER_X86
+
+/**
+ * @brief Appends the offsets of the set bits of mask, relative to base.
+ */
+inline size_t flattenMask(uint32_t mask, size_t base, uint32_t* indexes, size_t count) {
+    while (mask) {
+        indexes[count++] = static_cast<uint32_t>(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+__attribute__((target("sse2")))
+size_t scanSse2(const char* text, size_t length, uint32_t* indexes) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0, i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, newline));
+        count = flattenMask(static_cast<uint32_t>(_mm_movemask_epi8(hits)), i, indexes, count);
+    }
+    return scanTail(text, i, length, indexes, count);
+}
+
+__attribute__((target("avx2")))
+size_t scanAvx2(const char* text, size_t length, uint32_t* indexes) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0, i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(block, comma), _mm256_cmpeq_epi8(block, newline));
+        count = flattenMask(static_cast<uint32_t>(_mm256_movemask_epi8(hits)), i, indexes, count);
+    }
+    return scanTail(text, i, length, indexes, count);
+}
+
+#endif
+
+struct Implementation {
+    ScanFunction scan;
+    const char* name;
+};
+
+Implementation detect() {
+#ifdef CSV_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {scanAvx2, "avx2"};
+    if (__builtin_cpu_supports("sse2")) return {scanSse2, "sse2"};
+#endif
+    return {scanScalar, "scalar"};
+}
+
+const Implementation& selected() {
+    static const Implementation implementation = detect();
+    return implementation;
+}
+
+} // namespace
+
+size_t CsvScanner::scan(std::string_view text, uint32_t* indexes) {
+    return selected().scan(text.data(), text.size(), indexes);
+}
+
+const char* CsvScanner::implementation() { return selected().name; }
@@ -0,0 +1,37 @@
+/**
+* @file CsvScanner.h
+ * @brief Vectorised search for the structural characters of CSV input
+ */
+
+#ifndef CSV_SCANNER_H
+#define CSV_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @class CsvScanner
+ * @brief Finds every field separator (',') and line break ('\n') in a block of text
+ * @details The scan is done with AVX2 or SSE2 when the CPU supports them and with a
+ * plain byte loop otherwise. The implementation is chosen once, at first use.
+ */
+class CsvScanner {
+public:
+    /**
+     * @brief Writes the offset of every ',' and '\n' in text, in increasing order.
+     * @param text The block to scan, at most 4 GiB long.
+     * @param indexes Output array with room for at least text.size() entries.
+     * @return Number of offsets written.
+     * @complexity O(N) where N is the length of text.
+     */
+    static size_t scan(std::string_view text, uint32_t* indexes);
+
+    /**
+     * @brief Name of the implementation selected for this CPU.
+     * @return "avx2", "sse2" or "scalar".
+     */
+    static const char* implementation();
+};
+
+#endif // CSV_SCANNER_H
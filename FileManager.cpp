@@ -1,56 +1,313 @@
 #include "FileManager.h"
 #include "Graph.h"
+#include "CsvScanner.h"
+#include "LoadProfile.h"
+#include "MappedFile.h"
+#include "ResultWriter.h"
+#include "Trace.h"
+#include <charconv>
 #include <fstream>
 #include <sstream>
+#include <string_view>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
 using namespace std;
 
-void FileManager::loadLocations(const string& filename, Graph* graph) {
-    ifstream file(filename);
-    if (!file) {
+namespace {
+
+/**
+ * @struct CsvRow
+ * @brief Fields of one CSV row, viewing the mapped file
+ * @details Missing fields read as empty views and fields past MAX_FIELDS are dropped.
+ */
+struct CsvRow {
+    static constexpr size_t MAX_FIELDS = 8;
+    string_view fields[MAX_FIELDS];
+    size_t count = 0;
+
+    string_view operator[](size_t i) const { return i < count ? fields[i] : string_view(); }
+};
+
+constexpr size_t SCAN_BLOCK_BYTES = 64 * 1024; ///< Text scanned per CsvScanner call, so the index stays in cache
+
+/**
+ * @brief Parses a whole field as a decimal integer.
+ * @return True if the field is a valid integer with no trailing characters.
+ */
+bool parseInt(string_view field, int& value) {
+    auto [end, ec] = from_chars(field.data(), field.data() + field.size(), value);
+    return ec == errc() && end == field.data() + field.size();
+}
+
+/**
+ * @brief Returns the text following the header line.
+ */
+string_view skipHeader(string_view text) {
+    size_t newline = text.find('\n');
+    return newline == string_view::npos ? string_view() : text.substr(newline + 1);
+}
+
+/**
+ * @brief Calls onRow for every non-empty line of text.
+ * @details The text is scanned for separators in blocks with CsvScanner and rows are
+ * cut from the resulting structural index. A trailing carriage return is stripped so
+ * CRLF files parse the same as LF ones. onRow receives the row and its line number,
+ * counting the first line as firstLine.
+ * @return Number of lines in text.
+ */
+template <typename RowHandler>
+size_t forEachRow(string_view text, size_t firstLine, RowHandler onRow) {
+    vector<uint32_t> indexes(min(text.size(), SCAN_BLOCK_BYTES * 2));
+    size_t lineNumber = firstLine;
+    CsvRow row;
+    auto endRow = [&](string_view lastField) {
+        if (!lastField.empty() && lastField.back() == '\r') lastField.remove_suffix(1);
+        if (row.count < CsvRow::MAX_FIELDS) row.fields[row.count++] = lastField;
+        if (row.count > 1 || !row.fields[0].empty()) onRow(row, lineNumber);
+        row.count = 0;
+        ++lineNumber;
+    };
+    while (!text.empty()) {
+        // Cut the block at a line break so no row straddles two scans
+        size_t newline = text.size() > SCAN_BLOCK_BYTES ? text.find('\n', SCAN_BLOCK_BYTES) : string_view::npos;
+        string_view block = text.substr(0, newline == string_view::npos ? text.size() : newline + 1);
+        text.remove_prefix(block.size());
+        if (indexes.size() < block.size()) indexes.resize(block.size());
+
+        size_t count = CsvScanner::scan(block, indexes.data());
+        size_t fieldStart = 0;
+        for (size_t i = 0; i < count; ++i) {
+            size_t position = indexes[i];
+            string_view field = block.substr(fieldStart, position - fieldStart);
+            fieldStart = position + 1;
+            if (block[position] == '\n') endRow(field);
+            else if (row.count < CsvRow::MAX_FIELDS) row.fields[row.count++] = field;
+        }
+        if (fieldStart < block.size()) endRow(block.substr(fieldStart));
+    }
+    return lineNumber - firstLine;
+}
+
+/**
+ * @brief Splits text into at most maxChunks pieces that each end on a line boundary.
+ */
+vector<string_view> splitAtLines(string_view text, size_t maxChunks) {
+    vector<string_view> chunks;
+    size_t target = text.size() / max<size_t>(maxChunks, 1) + 1;
+    while (!text.empty()) {
+        size_t newline = text.size() > target ? text.find('\n', target) : string_view::npos;
+        size_t length = newline == string_view::npos ? text.size() : newline + 1;
+        chunks.push_back(text.substr(0, length));
+        text.remove_prefix(length);
+    }
+    return chunks;
+}
+
+/**
+ * @brief Runs task(0) .. task(count - 1), one thread per task.
+ */
+template <typename Task>
+void runParallel(size_t count, Task task) {
+    if (count == 1) {
+        task(0);
+        return;
+    }
+    vector<thread> workers;
+    workers.reserve(count);
+    for (size_t i = 0; i < count; ++i) workers.emplace_back(task, i);
+    for (auto& worker : workers) worker.join();
+}
+
+/**
+ * @struct ParsedRoad
+ * @brief One road row of the distances file, with both ends resolved to dense location indexes
+ */
+struct ParsedRoad {
+    uint32_t from;
+    uint32_t to;
+    int drivingTime;
+    int walkingTime;
+};
+
+/**
+ * @struct ParsedLocation
+ * @brief One valid row of the locations file; the code views the mapped file
+ */
+struct ParsedLocation {
+    int id;
+    string_view code;
+    bool hasParking;
+};
+
+/**
+ * @struct RowError
+ * @brief A rejected row, with its line number relative to the start of its chunk
+ */
+struct RowError {
+    size_t line;
+    const char* reason;
+};
+
+constexpr size_t MIN_CHUNK_BYTES = 1 << 20; ///< Files smaller than this per thread are parsed with fewer threads
+
+void reportMalformedRow(const string& filename, size_t lineNumber, const char* reason) {
+    cerr << "Warning: " << filename << ":" << lineNumber << ": " << reason << ", row skipped" << endl;
+}
+
+/**
+ * @brief Calls onItem for every non-empty item of a separator-delimited list.
+ */
+template <typename ItemHandler>
+void forEachItem(string_view list, char separator, ItemHandler onItem) {
+    while (!list.empty()) {
+        size_t end = list.find(separator);
+        string_view item = list.substr(0, end);
+        if (!item.empty()) onItem(item);
+        list.remove_prefix(end == string_view::npos ? list.size() : end + 1);
+    }
+}
+
+} // namespace
+
+void FileManager::loadLocations(const string& filename, Graph* graph, LoadProfile* profile) {
+    TraceSpan span("loadLocations");
+    LoadProfile::Scope phase(profile, "read locations");
+    MappedFile file;
+    if (!file.open(filename)) {
         cerr << "Error: Unable to open " << filename << endl;
         return;
     }
-    string line;
-    getline(file, line); // Skip header
-    while (getline(file, line)) {
-        stringstream ss(line);
-        string name, idStr, code, parkingStr;
-        getline(ss, name, ',');
-        getline(ss, idStr, ',');
-        getline(ss, code, ',');
-        getline(ss, parkingStr, ',');
-        if (idStr.empty() || code.empty() || parkingStr.empty()) continue;
-        int id = stoi(idStr);
-        bool hasParking = (parkingStr == "1");
-        graph->addLocation(id, code, hasParking);
+    phase.addBytes(file.size());
+    vector<ParsedLocation> parsed;
+    size_t rejected = 0;
+    forEachRow(skipHeader(file.view()), 2, [&](const CsvRow& row, size_t lineNumber) {
+        // row[0] is the location name, which is not used
+        string_view idStr = row[1];
+        string_view codeStr = row[2];
+        string_view parkingStr = row[3];
+        int id;
+        if (idStr.empty() || codeStr.empty() || parkingStr.empty()) {
+            reportMalformedRow(filename, lineNumber, "missing field");
+            ++rejected;
+            return;
+        }
+        if (!parseInt(idStr, id)) {
+            reportMalformedRow(filename, lineNumber, "invalid location id");
+            ++rejected;
+            return;
+        }
+        parsed.push_back({id, codeStr, parkingStr == "1"});
+    });
+    phase.addRows(parsed.size() + rejected, rejected);
+
+    phase.next("code index");
+    graph->reserveLocations(parsed.size());
+    string code;
+    for (const auto& location : parsed) {
+        code.assign(location.code);
+        graph->addLocation(location.id, code, location.hasParking);
     }
-    file.close();
 }
 
-void FileManager::loadDistances(const string& filename, Graph* graph) {
-    ifstream file(filename);
-    if (!file) {
+void FileManager::loadDistances(const string& filename, Graph* graph, unsigned threads, LoadProfile* profile) {
+    TraceSpan span("loadDistances");
+    LoadProfile::Scope phase(profile, "read distances");
+    MappedFile file;
+    if (!file.open(filename)) {
         cerr << "Error: Unable to open " << filename << endl;
         return;
     }
-    string line;
-    getline(file, line); // Skip header
-    while (getline(file, line)) {
-        stringstream ss(line);
-        string loc1Code, loc2Code, drivingStr, walkingStr;
-        getline(ss, loc1Code, ',');
-        getline(ss, loc2Code, ',');
-        getline(ss, drivingStr, ',');
-        getline(ss, walkingStr, ',');
-        if (loc1Code.empty() || loc2Code.empty()) continue;
-        auto loc1 = graph->findLocation(loc1Code);
-        auto loc2 = graph->findLocation(loc2Code);
-        if (!loc1 || !loc2) continue;
-        int drivingTime = (drivingStr == "X") ? INF : stoi(drivingStr);
-        int walkingTime = stoi(walkingStr);
-        graph->addRoad(loc1, loc2, drivingTime, walkingTime);
+    phase.addBytes(file.size());
+    string_view body = skipHeader(file.view());
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = static_cast<unsigned>(min<size_t>(threads, body.size() / MIN_CHUNK_BYTES + 1));
+
+    // Parse chunks into thread-local road buffers; findLocation only reads the graph
+    vector<string_view> chunks = splitAtLines(body, threads);
+    vector<vector<ParsedRoad>> roads(chunks.size());
+    vector<vector<RowError>> errors(chunks.size());
+    vector<size_t> lineCounts(chunks.size());
+    runParallel(chunks.size(), [&](size_t c) {
+        TraceSpan chunk("parseRoads", "chunk", static_cast<int64_t>(c));
+        auto& out = roads[c];
+        auto reject = [&](size_t line, const char* reason) { errors[c].push_back({line, reason}); };
+        lineCounts[c] = forEachRow(chunks[c], 0, [&](const CsvRow& row, size_t line) {
+            string_view loc1Code = row[0];
+            string_view loc2Code = row[1];
+            string_view drivingStr = row[2];
+            string_view walkingStr = row[3];
+            if (loc1Code.empty() || loc2Code.empty()) return reject(line, "missing location code");
+            auto loc1 = graph->findLocation(loc1Code);
+            auto loc2 = graph->findLocation(loc2Code);
+            if (!loc1 || !loc2) return reject(line, "unknown location code");
+            int drivingTime, walkingTime;
+            if (drivingStr == "X") drivingTime = INF;
+            else if (!parseInt(drivingStr, drivingTime)) return reject(line, "invalid driving time");
+            if (!parseInt(walkingStr, walkingTime)) return reject(line, "invalid walking time");
+            out.push_back({static_cast<uint32_t>(loc1->getIndex()), static_cast<uint32_t>(loc2->getIndex()),
+                           drivingTime, walkingTime});
+        });
+    });
+    size_t firstLine = 2;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        for (const auto& error : errors[c]) reportMalformedRow(filename, firstLine + error.line, error.reason);
+        firstLine += lineCounts[c];
+        phase.addRows(roads[c].size() + errors[c].size(), errors[c].size());
     }
-    file.close();
+
+    phase.next("build adjacency");
+
+    // Counting sort of the directed roads (both directions of every row) by origin bucket.
+    // The sort is stable, so every location receives its roads in file order, exactly as
+    // repeated Graph::addRoad calls would add them, whatever the number of threads.
+    const auto& locations = graph->getLocations();
+    unsigned shift = 0;
+    while ((locations.size() >> shift) >= (1u << 16)) ++shift;
+    size_t bucketCount = (locations.size() >> shift) + 1;
+    vector<vector<size_t>> bucketOffsets(chunks.size(), vector<size_t>(bucketCount, 0));
+    runParallel(chunks.size(), [&](size_t c) {
+        TraceSpan chunk("countRoads", "chunk", static_cast<int64_t>(c));
+        for (const auto& road : roads[c]) {
+            ++bucketOffsets[c][road.from >> shift];
+            ++bucketOffsets[c][road.to >> shift];
+        }
+    });
+    vector<size_t> bucketStart(bucketCount + 1, 0);
+    size_t offset = 0;
+    for (size_t b = 0; b < bucketCount; ++b) {
+        bucketStart[b] = offset;
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            size_t count = bucketOffsets[c][b];
+            bucketOffsets[c][b] = offset;
+            offset += count;
+        }
+    }
+    bucketStart[bucketCount] = offset;
+
+    vector<ParsedRoad> directed(offset);
+    runParallel(chunks.size(), [&](size_t c) {
+        TraceSpan chunk("scatterRoads", "chunk", static_cast<int64_t>(c));
+        auto& next = bucketOffsets[c];
+        for (const auto& road : roads[c]) {
+            directed[next[road.from >> shift]++] = road;
+            directed[next[road.to >> shift]++] = {road.to, road.from, road.drivingTime, road.walkingTime};
+        }
+        vector<ParsedRoad>().swap(roads[c]);
+    });
+
+    // Each thread owns a contiguous range of buckets, hence a disjoint set of origins
+    size_t workers = min<size_t>(threads, bucketCount);
+    runParallel(workers, [&](size_t w) {
+        TraceSpan range("linkRoads", "worker", static_cast<int64_t>(w));
+        size_t begin = bucketStart[bucketCount * w / workers];
+        size_t end = bucketStart[bucketCount * (w + 1) / workers];
+        for (size_t i = begin; i < end; ++i) {
+            const auto& road = directed[i];
+            Location* origin = locations[road.from];
+            origin->addRoad(new Road(origin, locations[road.to], road.drivingTime, road.walkingTime));
+        }
+    });
 }
 
 Input FileManager::readInputFile(const string& filename, const int& typeOfInput) {
@@ -123,116 +380,63 @@ Input FileManager::readInputFile(const string& filename, const int& typeOfInput)
     return input;
 }
 
-void FileManager::writeOutputFile(const string& filename, const Output &output) {
-    ofstream file(filename);
-    if (!file) {
+vector<Input> FileManager::loadQueries(const string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
         cerr << "Error: Unable to open " << filename << endl;
-        return;
+        return {};
     }
 
-    file << "Source:" << output.sourceId << "\n";
-    file << "Destination:" << output.destId << "\n";
-
-    if (output.TypeOfInput == 0) {
-        file << "BestDrivingRoute:";
-        if (output.bestPath.first.empty()) file << "none\n";
+    vector<Input> queries;
+    forEachRow(skipHeader(file.view()), 2, [&](const CsvRow& row, size_t lineNumber) {
+        Input input;
+        string_view mode = row[0];
+        if (mode == "driving") input.TypeOfInput = 0;
+        else if (mode == "restricted") input.TypeOfInput = 1;
+        else if (mode == "driving-walking") input.TypeOfInput = 2;
         else {
-            for (size_t i = 0; i < output.bestPath.first.size(); ++i) {
-                file << output.bestPath.first[i];
-                if (i < output.bestPath.first.size() - 1) file << ",";
-            }
-            file << " (" << output.bestPath.second << " min)\n";
+            reportMalformedRow(filename, lineNumber, "unknown mode");
+            return;
         }
-
-        file << "AlternativeRoute:";
-        if (output.altPath.first.empty()) file << "none\n";
-        else {
-            for (size_t i = 0; i < output.altPath.first.size(); ++i) {
-                file << output.altPath.first[i];
-                if (i < output.altPath.first.size() - 1) file << ",";
-            }
-            file << " (" << output.altPath.second << " min)\n";
+        if (!parseInt(row[1], input.sourceId) || !parseInt(row[2], input.destId)
+            || (!row[3].empty() && !parseInt(row[3], input.maxWalkingTime))
+            || (!row[4].empty() && !parseInt(row[4], input.includeNodeId))) {
+            reportMalformedRow(filename, lineNumber, "invalid ID or time");
+            return;
         }
-    }
-
-    if (output.TypeOfInput == 1) {
-        file << "RestrictedDrivingRoute:";
-        if (output.bestPath.first.empty()) file << "none\n";
-        else {
-            for (size_t i = 0; i < output.bestPath.first.size(); ++i) {
-                file << output.bestPath.first[i];
-                if (i < output.bestPath.first.size() - 1) file << ",";
-            }
-            file << " (" << output.bestPath.second << " min)\n";
+        if (input.TypeOfInput == 2 && input.maxWalkingTime < 0) {
+            reportMalformedRow(filename, lineNumber, "missing maximum walking time");
+            return;
         }
-    }
-
-    if (output.TypeOfInput == 2) {
-        // Case 1: No route found at all
-        if (output.bestPath.first.empty() && output.altPath.first.empty() && 
-            output.parkingNode == -1 && !output.hasSuggestions) {
-            file << "DrivingRoute:none\n";
-            file << "ParkingNode:none\n";
-            file << "WalkingRoute:none\n";
-            file << "TotalTime:none\n";
-            file << "Message:No possible route with max walking time of "
-                 << output.maxWalkingTime << " minutes.\n";
-        }
-        // Case 2: Found exact route (within walking limit)
-        else if (!output.hasSuggestions) {
-            file << "DrivingRoute:";
-            if (output.bestPath.first.empty()) file << "none\n";
-            else {
-                for (size_t i = 0; i < output.bestPath.first.size(); ++i) {
-                    file << output.bestPath.first[i];
-                    if (i < output.bestPath.first.size() - 1) file << ",";
-                }
-                file << " (" << output.bestPath.second << " min)\n";
-            }
-
-            file << "ParkingNode:" << output.parkingNode << "\n";
-
-            file << "WalkingRoute:";
-            if (output.altPath.first.empty()) file << "none\n";
-            else {
-                for (size_t i = 0; i < output.altPath.first.size(); ++i) {
-                    file << output.altPath.first[i];
-                    if (i < output.altPath.first.size() - 1) file << ",";
-                }
-                file << " (" << output.altPath.second << " min)\n";
-            }
 
-            file << "TotalTime:" << output.totalTime << "\n";
-        }
-        // Case 3: Only have suggestions (exceed walking time)
-        else {
-            for (auto a : output.suggestions) {
-                cout << a.totalTime << endl;
-            }
-            for(size_t i = 0; i < 2; i++){
-                const auto& suggestion = output.suggestions[i];
-
-                file << "DrivingRoute" << i + 1 << ":";
-                for (size_t j = 0; j < suggestion.drivePath.size(); j++){
-                    file << suggestion.drivePath[j];
-                    if (j < suggestion.drivePath.size() - 1) file << ",";
-                }
-                file << " (" << (suggestion.totalTime - suggestion.walkingTime) << " min)\n";
-
-                file << "ParkingNode" << i + 1 << ":" << suggestion.parkingNode << " \n";
-
-                file << "WalkingRoute1:";
-                for (size_t j = 0; j < suggestion.walkPath.size();j++){
-                    file << suggestion.walkPath[j];
-                    if( j < suggestion.walkPath.size() - 1) file << ",";
-                }
-    
-                file << " (" << suggestion.walkingTime << " min)";
-                file << "(Exceeds by " << suggestion.exceedWalkingBy << " min)\n";
-                file << "TotalTime" << i + 1 << ":" << suggestion.totalTime << "\n";
+        bool valid = true;
+        forEachItem(row[5], ';', [&](string_view item) {
+            int node;
+            if (parseInt(item, node)) input.avoidNodes.insert(node);
+            else valid = false;
+        });
+        forEachItem(row[6], ';', [&](string_view item) {
+            size_t dash = item.find('-', 1); // Skip a leading minus sign
+            int from, to;
+            if (dash != string_view::npos && parseInt(item.substr(0, dash), from) && parseInt(item.substr(dash + 1), to)) {
+                input.avoidSegments.insert({from, to});
+            } else {
+                valid = false;
             }
-    
+        });
+        if (!valid) {
+            reportMalformedRow(filename, lineNumber, "invalid avoid list");
+            return;
         }
-    file.close();
-    }
+        queries.push_back(std::move(input));
+    });
+    return queries;
+}
+
+void FileManager::writeOutputFile(const string& filename, const Output &output, bool includeStats) {
+    static thread_local ResultWriter writer; // Keeps its buffer between queries
+    if (!writer.open(filename)) return;
+    writer.includeStats(includeStats);
+    writer.write(output);
+    writer.close();
 }
@@ -7,6 +7,9 @@
 #define FILES_MANAGER
 
 #include "Graph.h"
+#include "SearchStats.h"
+
+class LoadProfile;
 
 /**
  * @struct Input
@@ -100,6 +103,10 @@ struct Output {
      * @brief The maximum allowed walking time for environmentally friendly routes.
      */
     int maxWalkingTime = -1;
+    /**
+     * @brief Work done by the searches of this query (zero when built without ROUTE_SEARCH_STATS).
+     */
+    SearchStats stats;
 };
 
 /**
@@ -118,29 +125,55 @@ public:
  */
 static Input readInputFile(const std::string &filename, const int& typeOfInput);
 
+/**
+ * @brief Reads a batch of queries from a CSV file.
+ * @details After a header line, each row is
+ * Mode,Source,Destination,MaxWalkingTime,IncludeNode,AvoidNodes,AvoidSegments where Mode is
+ * driving, restricted or driving-walking, optional fields may be left empty, AvoidNodes
+ * is a ';'-separated list of IDs and AvoidSegments a ';'-separated list of from-to pairs.
+ * Malformed rows are reported with their line number and skipped.
+ * @param filename The name of the CSV file to read.
+ * @return The queries, in file order.
+ * @complexity O(N) where N is the size of the file.
+ */
+static std::vector<Input> loadQueries(const std::string &filename);
+
 /**
  * @brief Writes the best and alternative routes to an output file.
  * @param filename The output file name.
  * @param output Contains all the possible output parameters.
+ * @param includeStats Also write the search statistics of the query.
  * @complexity O(N) where N is the path length.
  */
-static void writeOutputFile(const std::string &filename, const Output &output);
+static void writeOutputFile(const std::string &filename, const Output &output, bool includeStats = false);
 
 /**
  * @brief Reads and loads location data from the Locations.csv file.
+ * @details The file is memory-mapped and scanned in place; malformed rows are
+ * reported with their line number and skipped. The valid rows are then added to the
+ * graph in one pass, with its indexes sized up front.
  * @param filename The name of the CSV file to read.
  * @param RoadMap Pointer to Graph where locations are being loaded.
+ * @param profile Receives the "read locations" and "code index" phases, if given.
  * @complexity O(N) where N is the number of locations in the file.
  */
-static void loadLocations(const std::string &filename, Graph* RoadMap);
+static void loadLocations(const std::string &filename, Graph* RoadMap, LoadProfile* profile = nullptr);
 
 /**
  * @brief Reads and loads distance data from the Distances.csv.
+ * @details The file is memory-mapped, split into chunks at line boundaries and the
+ * chunks are parsed in parallel. The roads are then grouped by origin with a stable
+ * counting sort, so the resulting adjacency lists are identical for any thread count.
+ * A driving time of "X" marks a road that cannot be driven. Malformed rows are
+ * reported with their line number and skipped.
  * @param filename The name of the CSV file to read.
  * @param RoadMap Pointer to Graph where distances are being loaded.
- * @complexity O(N) where N is the number of roads in the file.
+ * @param threads Number of parsing threads, 0 to use every hardware thread.
+ * @param profile Receives the "read distances" and "build adjacency" phases, if given.
+ * @complexity O(N + M / T) where N is the number of locations, M the number of roads and T the number of threads.
  */
-static void loadDistances(const std::string &filename, Graph* RoadMap);
+static void loadDistances(const std::string &filename, Graph* RoadMap, unsigned threads = 0,
+                          LoadProfile* profile = nullptr);
 
 };
 
@@ -1,4 +1,8 @@
 #include "Graph.h"
+#include "MemoryReport.h"
+#include "PerfCounters.h"
+#include "SearchStats.h"
+#include "Trace.h"
 #include <queue>
 #include <algorithm>
 
@@ -21,13 +25,17 @@ int Road::getWalkingTime() const { return walkingTime; }
 
 void Road::setDrivingTime(int newDrivingTime) { this->drivingTime = newDrivingTime; }
 
+void Road::setWalkingTime(int newWalkingTime) { this->walkingTime = newWalkingTime; }
 
-Location::Location(int id, std::string code, bool hasParking)
-    : id(id), code(std::move(code)), hasParking(hasParking), parent(nullptr), distance(0) {}
+
+Location::Location(int id, std::string code, bool hasParking, int index)
+    : id(id), index(index), code(std::move(code)), hasParking(hasParking), parent(nullptr), distance(0) {}
 
 int Location::getId() const { return id; }
 
-std::string Location::getCode() const { return code; }
+int Location::getIndex() const { return index; }
+
+const std::string& Location::getCode() const { return code; }
 
 bool Location::HasParking() const { return hasParking; }
 
@@ -54,21 +62,86 @@ const std::vector<Location*>& Graph::getLocations() const {
 }
 
 void Graph::addLocation(const int &id, const std::string &code, const bool &hasParking) {
-    locations.push_back(new Location(id, code, hasParking));
+    auto* location = new Location(id, code, hasParking, static_cast<int>(locations.size()));
+    locations.push_back(location);
+    // First location wins on duplicates, as the old linear scan did
+    codeIndex.emplace(location->getCode(), location);
+    idIndex.emplace(id, location);
+}
+
+void Graph::reserveLocations(size_t count) {
+    locations.reserve(locations.size() + count);
+    codeIndex.reserve(codeIndex.size() + count);
+    idIndex.reserve(idIndex.size() + count);
+}
+
+bool Graph::updateRoad(int fromId, int toId, int drivingTime, int walkingTime) {
+    Location* from = findLocation(fromId);
+    Location* to = findLocation(toId);
+    if (!from || !to) return false;
+    bool found = false;
+    auto update = [&](Location* origin, Location* destination) {
+        for (Road* road : origin->getAdj()) {
+            if (road->getDestination() != destination) continue;
+            if (drivingTime >= 0) road->setDrivingTime(drivingTime);
+            if (walkingTime >= 0) road->setWalkingTime(walkingTime);
+            found = true;
+        }
+    };
+    update(from, to);
+    update(to, from);
+    if (found) ++revision;
+    return found;
 }
 
-Location* Graph::findLocation(const std::string& code) const {
-    for (auto* location : locations) {
-        if (location->getCode() == code) return location;
+int Graph::roadTime(int fromId, int toId, bool isDriving) const {
+    const Location* from = findLocation(fromId);
+    if (!from) return INF;
+    int best = INF;
+    for (const Road* road : from->getAdj()) {
+        if (road->getDestination()->getId() != toId) continue;
+        best = std::min(best, isDriving ? road->getDrivingTime() : road->getWalkingTime());
     }
-    return nullptr;
+    return best;
 }
 
-Location* Graph::findLocation(const int &id) const {
-    for (auto* location : locations) {
-        if (location->getId() == id) return location;
+Neighbourhood Graph::neighbourhood(int sourceId, bool isDriving, size_t limit) const {
+    Neighbourhood near;
+    const Location* source = findLocation(sourceId);
+    if (!source) return near;
+    std::unordered_map<const Location*, int> tentative;
+    std::priority_queue<std::pair<int, const Location*>, std::vector<std::pair<int, const Location*>>, std::greater<>> pq;
+    tentative.emplace(source, 0);
+    pq.emplace(0, source);
+    while (!pq.empty()) {
+        auto [distance, location] = pq.top();
+        pq.pop();
+        if (distance > tentative[location] || near.distances.count(location->getId())) continue;
+        if (near.distances.size() == limit) {
+            near.radius = distance;
+            return near;
+        }
+        near.distances.emplace(location->getId(), distance);
+        for (const Road* road : location->getAdj()) {
+            int time = isDriving ? road->getDrivingTime() : road->getWalkingTime();
+            if (time == INF) continue;
+            auto [it, added] = tentative.emplace(road->getDestination(), distance + time);
+            if (!added && it->second <= distance + time) continue;
+            it->second = distance + time;
+            pq.emplace(distance + time, road->getDestination());
+        }
     }
-    return nullptr;
+    return near;
+}
+
+Location* Graph::findLocation(std::string_view code) const {
+    auto it = codeIndex.find(code);
+    return it == codeIndex.end() ? nullptr : it->second;
+}
+
+Location* Graph::findLocation(const int &id) const {
+    auto it = idIndex.find(id);
+    return it == idIndex.end() ? nullptr : it->second;
 }
 
 void Graph::addRoad(Location* from, Location* to, int drivingTime, int walkingTime) {
@@ -86,7 +159,9 @@ std::pair<std::vector<int>, int> Graph::dijkstra(
 
     std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> pq;
 
+    TraceSpan span("dijkstra", "source", sourceId, "destination", destinationId);
     // Initialization
+    PerfPhase phase(PerfProfile::Initialisation);
     for (const auto& loc : getLocations()) {
         loc->setDistance(INF);
         loc->setParent(nullptr);
@@ -94,27 +169,43 @@ std::pair<std::vector<int>, int> Graph::dijkstra(
     auto source = findLocation(sourceId);
     source->setDistance(0);
     pq.emplace(source->getDistance(), sourceId);
+    SEARCH_STAT(pushes);
 
+    phase.next(PerfProfile::Search);
     while (!pq.empty()) {
         auto [currentDist, currentNodeId] = pq.top();
         auto currentNode = findLocation(currentNodeId);
         pq.pop();
-        if (currentDist > currentNode->getDistance()) continue;
+        SEARCH_STAT(pops);
+        if (currentDist > currentNode->getDistance()) {
+            SEARCH_STAT(stalePops);
+            continue;
+        }
 
-        if (blockedNodes.count(currentNodeId)) continue;
+        if (blockedNodes.count(currentNodeId)) {
+            SEARCH_STAT(blockedSkips);
+            continue;
+        }
+        SEARCH_STAT(settled);
 
         for (const auto& road : findLocation(currentNodeId)->getAdj()) {
             int edgeWeight = isDriving ? road->getDrivingTime() : road->getWalkingTime();
             if (edgeWeight == INF) continue;
-            if (blockedSegments.count({currentNodeId, road->getDestination()->getId()})) continue;
+            if (blockedSegments.count({currentNodeId, road->getDestination()->getId()})) {
+                SEARCH_STAT(blockedSkips);
+                continue;
+            }
+            SEARCH_STAT(relaxed);
             int newDist = currentDist + edgeWeight;
             if (newDist < road->getDestination()->getDistance()) {
                 road->getDestination()->setDistance(newDist);
                 road->getDestination()->setParent(road);
                 pq.emplace(newDist, road->getDestination()->getId());
+                SEARCH_STAT(pushes);
             }
         }
     }
+    phase.next(PerfProfile::PathReconstruction);
     auto destination = findLocation(destinationId);
     int dist = destination->getDistance();
     if (dist == INF) return {};
@@ -145,6 +236,7 @@ Graph::EnvironmentallyFriendlyRoute(
         if (!parkingNode->HasParking() || parkingNode->getId() == sourceId || parkingNode->getId() == destId) {
             continue;
         }
+        SEARCH_STAT(parkingCandidates);
 
         auto tmpSegments = avoidSegments;
         // Driving segment
@@ -185,4 +277,21 @@ Graph::EnvironmentallyFriendlyRoute(
     }
 
     return {bestDrive, bestWalk, bestParking, bestTotalTime, bestWalkingTime, suggestions};
-}
\ No newline at end of file
+}
+
+void Graph::reportMemory(MemoryReport& report) const {
+    size_t roads = 0, adjacency = 0, codes = 0;
+    for (const auto* location : locations) {
+        roads += location->getAdj().size();
+        adjacency += MemoryReport::vectorBytes(location->getAdj());
+        codes += MemoryReport::stringBytes(location->getCode());
+    }
+    report.setShape(locations.size(), roads);
+    report.add("graph", "locations", MemoryReport::vectorBytes(locations)
+                                     + locations.size() * MemoryReport::allocation(sizeof(Location)));
+    report.add("graph", "roads", roads * MemoryReport::allocation(sizeof(Road)));
+    report.add("graph", "adjacency", adjacency);
+    report.add("graph", "codes", codes);
+    report.add("graph", "code index", MemoryReport::hashTableBytes(codeIndex));
+    report.add("graph", "id index", MemoryReport::hashTableBytes(idIndex));
+}
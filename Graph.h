@@ -6,13 +6,17 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <unordered_set>
+#include <unordered_map>
+#include <string_view>
 #include <limits>
 #include <functional>
+#include <cstdint>
 
 #define INF std::numeric_limits<int>::max()
 
@@ -33,7 +37,46 @@ struct pair_hash {
     size_t operator()(const std::pair<int, int>& p) const;
 };
 
+/**
+ * @struct Neighbourhood
+ * @brief Exact distances from a location to the locations nearest it
+ * @details Roads are two-way with the same times, so these are also the distances to it.
+ */
+struct Neighbourhood {
+    std::unordered_map<int, int> distances;   ///< Location ID -> distance, for the locations settled
+    int radius = INF;                         ///< No other location is closer; INF if the search settled every reachable one
+
+    /**
+     * @brief Lower bound of the distance to a location: exact if settled, the radius otherwise.
+     */
+    int lowerBound(int id) const {
+        auto it = distances.find(id);
+        return it == distances.end() ? radius : it->second;
+    }
+
+    /**
+     * @brief Check if a route between two locations that takes a road may be as fast as a route of the given time.
+     * @details Such a route costs at least the distance from one end of the road to the source,
+     * plus its time, plus the distance from the other end to the destination.
+     * @param nearFrom, nearTo Neighbourhoods of the road's two ends.
+     * @param time The road's time.
+     * @param routeTime Time of the route to beat, INF if there is none.
+     */
+    static bool mayBeat(const Neighbourhood& nearFrom, const Neighbourhood& nearTo, int time,
+                        int sourceId, int destId, int routeTime) {
+        auto bound = [](const Neighbourhood& near, int id) -> int64_t {
+            int distance = near.lowerBound(id);
+            return distance == INF ? INT64_MAX / 4 : distance;
+        };
+        int64_t through = time + std::min(bound(nearFrom, sourceId) + bound(nearTo, destId),
+                                          bound(nearTo, sourceId) + bound(nearFrom, destId));
+        // A route through the road as fast as the current one could be chosen instead
+        return routeTime == INF ? through < INT64_MAX / 4 : through <= routeTime;
+    }
+};
+
 class Location;
+class MemoryReport;
 
 /**
  * @class Road
@@ -81,6 +124,12 @@ public:
     */
     void setDrivingTime(int drivingTime);
 
+    /**
+     * @brief Sets walking time to a new value.
+     * @param walkingTime New walking time.
+    */
+    void setWalkingTime(int walkingTime);
+
 private:
     Location* origin;       ///< Pointer to the origin Location
     Location* destination;  ///< Pointer to the destination Location
@@ -97,7 +146,7 @@ class Location {
 public:
     Location() = default;
 
-    Location(int id, std::string code, bool hasParking);
+    Location(int id, std::string code, bool hasParking, int index = -1);
 
     /**
      * @brief Get the location ID.
@@ -105,11 +154,17 @@ public:
      */
     int getId() const;
 
+    /**
+     * @brief Get the position of the location in Graph::getLocations().
+     * @return Dense index of the location, or -1 if it is not part of a graph.
+     */
+    int getIndex() const;
+
     /**
      * @brief Get the alphanumeric location code.
      * @return Location code.
      */
-    std::string getCode() const;
+    const std::string& getCode() const;
 
     /**
      * @brief Check if the location has parking.
@@ -154,6 +209,7 @@ public:
     void addRoad(Road* road);
 private:
     int id{};                           ///< Unique numeric ID
+    int index = -1;                     ///< Position in the owning graph's location list
     std::string code;                 ///< Alphanumeric location code
     bool hasParking{};                  ///< Parking availability
     std::vector<Road*> adj;           ///< Adjacency list of roads (neighbors)
@@ -182,13 +238,20 @@ public:
      */
     void addLocation(const int &id, const std::string &code,const bool &hasParking);
 
+    /**
+     * @brief Makes room for count more locations, so adding them does not rehash the indexes.
+     */
+    void reserveLocations(size_t count);
+
     /**
      * @brief Finds a location by its alphanumeric code.
+     * @complexity O(1) on average through the code index.
      */
-    Location* findLocation(const std::string& code) const;
+    Location* findLocation(std::string_view code) const;
 
     /**
      * @brief Finds a location by its numeric ID.
+     * @complexity O(1) on average through the ID index.
      */
     Location* findLocation(const int &id) const;
 
@@ -201,6 +264,35 @@ public:
      */
     void addRoad(Location* from, Location* to, int drivingTime, int walkingTime);
 
+    /**
+     * @brief Changes the times of the road between two locations, in both directions.
+     * @details A time of INF closes the road in that mode. Parallel roads between
+     * the two locations all take the new times. Every successful update advances version().
+     * @param drivingTime New driving time, or -1 to keep the current one.
+     * @param walkingTime New walking time, or -1 to keep the current one.
+     * @return False if the locations are not joined by a road.
+     * @complexity O(D) where D is the degree of the two locations.
+     */
+    bool updateRoad(int fromId, int toId, int drivingTime, int walkingTime);
+
+    /**
+     * @brief Number of road updates applied so far; results computed at another version may be stale.
+     */
+    uint64_t version() const { return revision; }
+
+    /**
+     * @brief Current time of the fastest road between two locations, INF if none is open.
+     * @complexity O(D) where D is the degree of fromId.
+     */
+    int roadTime(int fromId, int toId, bool isDriving) const;
+
+    /**
+     * @brief Dijkstra from a location that stops after settling limit locations.
+     * @details Unlike dijkstra(), leaves the search state of the locations untouched.
+     * @complexity O(L log L + E) where L is limit and E the roads of the settled locations.
+     */
+    Neighbourhood neighbourhood(int sourceId, bool isDriving, size_t limit) const;
+
     /**
      * @brief Finds an alternative independent route by excluding intermediate nodes from the best route.
      * @param sourceId The starting location code.
@@ -232,8 +324,17 @@ public:
         int sourceId, int destId, int maxWalkingTime,
         const std::unordered_set<int>& avoidNodes,
         std::unordered_set<std::pair<int, int>, pair_hash>& avoidSegments);
+
+    /**
+     * @brief Adds the locations, roads, adjacency lists, codes and lookup tables to a memory report.
+     * @complexity O(N) where N is the number of locations.
+     */
+    void reportMemory(MemoryReport& report) const;
 private:
     std::vector<Location*> locations;  ///< List of all locations
+    std::unordered_map<std::string_view, Location*> codeIndex;  ///< Code -> location, keys view each Location's code
+    std::unordered_map<int, Location*> idIndex;                 ///< ID -> location
+    uint64_t revision = 0;                                      ///< See version()
 };
 
 #endif // GRAPH_H
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "GraphSnapshot.h"
+#include "MemoryReport.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr char MAGIC[8] = {'R', 'T', 'S', 'N', 'A', 'P', 0, 0};
+
+size_t alignUp(size_t value) { return (value + 7) & ~size_t(7); }
+
+template <typename T>
+const T* sectionAt(const char* bytes, uint64_t offset) {
+    return reinterpret_cast<const T*>(bytes + offset);
+}
+
+} // namespace
+
+uint64_t GraphSnapshot::hashBytes(const void* data, size_t size, uint64_t seed) {
+    // FNV-1a style mixing over 64-bit words, with the tail folded in bytewise
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i) hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+std::vector<uint32_t> GraphSnapshot::breadthFirstOrder(const GraphSnapshot& graph) {
+    uint32_t nodeCount = graph.nodeCount();
+    std::vector<uint32_t> order;
+    std::vector<bool> visited(nodeCount, false);
+    order.reserve(nodeCount);
+    for (uint32_t root = 0; root < nodeCount; ++root) {
+        if (visited[root]) continue;
+        visited[root] = true;
+        order.push_back(root);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            uint32_t node = order[head];
+            for (uint32_t e = graph.edgesBegin(node); e < graph.edgesEnd(node); ++e) {
+                uint32_t next = graph.target(e);
+                if (visited[next]) continue;
+                visited[next] = true;
+                order.push_back(next);
+            }
+        }
+    }
+    return order;
+}
+
+GraphSnapshot GraphSnapshot::fromGraph(const Graph& graph, bool localityOrder) {
+    TraceSpan span("buildSnapshot");
+    const auto& all = graph.getLocations();
+    std::vector<const Location*> locations(all.begin(), all.end());
+    if (localityOrder) {
+        std::vector<uint32_t> order = breadthFirstOrder(fromGraph(graph));
+        for (size_t i = 0; i < order.size(); ++i) locations[i] = all[order[i]];
+    }
+    std::vector<uint32_t> rank(locations.size());
+    for (size_t i = 0; i < locations.size(); ++i) rank[locations[i]->getIndex()] = static_cast<uint32_t>(i);
+
+    size_t nodeCount = locations.size(), edgeCount = 0, stringsSize = 0;
+    for (const auto* location : locations) {
+        edgeCount += location->getAdj().size();
+        stringsSize += location->getCode().size();
+    }
+
+    SnapshotHeader head{};
+    std::memcpy(head.magic, MAGIC, sizeof(MAGIC));
+    head.version = VERSION;
+    head.headerSize = sizeof(SnapshotHeader);
+    head.nodeCount = static_cast<uint32_t>(nodeCount);
+    head.edgeCount = static_cast<uint32_t>(edgeCount);
+    size_t offset = alignUp(sizeof(SnapshotHeader));
+    auto place = [&](uint64_t& field, size_t bytes) {
+        field = offset;
+        offset = alignUp(offset + bytes);
+    };
+    place(head.nodesOffset, nodeCount * sizeof(SnapshotNode));
+    place(head.idIndexOffset, nodeCount * sizeof(SnapshotIdEntry));
+    place(head.adjOffset, (nodeCount + 1) * sizeof(uint32_t));
+    place(head.targetsOffset, edgeCount * sizeof(uint32_t));
+    place(head.drivingOffset, edgeCount * sizeof(int32_t));
+    place(head.walkingOffset, edgeCount * sizeof(int32_t));
+    place(head.stringsOffset, stringsSize);
+    head.stringsSize = stringsSize;
+    head.fileSize = offset;
+
+    GraphSnapshot snapshot;
+    snapshot.buffer.assign(offset / sizeof(uint64_t), 0);
+    char* bytes = reinterpret_cast<char*>(snapshot.buffer.data());
+    auto* nodes = reinterpret_cast<SnapshotNode*>(bytes + head.nodesOffset);
+    auto* idIndex = reinterpret_cast<SnapshotIdEntry*>(bytes + head.idIndexOffset);
+    auto* adj = reinterpret_cast<uint32_t*>(bytes + head.adjOffset);
+    auto* targets = reinterpret_cast<uint32_t*>(bytes + head.targetsOffset);
+    auto* driving = reinterpret_cast<int32_t*>(bytes + head.drivingOffset);
+    auto* walking = reinterpret_cast<int32_t*>(bytes + head.walkingOffset);
+    char* strings = bytes + head.stringsOffset;
+
+    uint32_t edge = 0, stringOffset = 0;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const auto* location = locations[i];
+        const std::string& code = location->getCode();
+        nodes[i] = {location->getId(), stringOffset, static_cast<uint32_t>(code.size()),
+                    location->HasParking() ? PARKING_FLAG : 0u};
+        std::memcpy(strings + stringOffset, code.data(), code.size());
+        stringOffset += static_cast<uint32_t>(code.size());
+        idIndex[i] = {location->getId(), static_cast<uint32_t>(i)};
+        adj[i] = edge;
+        for (const auto* road : location->getAdj()) {
+            targets[edge] = rank[road->getDestination()->getIndex()];
+            driving[edge] = road->getDrivingTime();
+            walking[edge] = road->getWalkingTime();
+            ++edge;
+        }
+    }
+    adj[nodeCount] = edge;
+    // Stable, so duplicated IDs resolve to the first location as in Graph::findLocation
+    std::stable_sort(idIndex, idIndex + nodeCount,
+                     [](const SnapshotIdEntry& a, const SnapshotIdEntry& b) { return a.id < b.id; });
+
+    head.checksum = hashBytes(bytes + sizeof(SnapshotHeader), offset - sizeof(SnapshotHeader));
+    std::memcpy(bytes, &head, sizeof(head));
+    snapshot.attach(bytes, offset, false, "in-memory snapshot");
+    return snapshot;
+}
+
+bool GraphSnapshot::write(const Graph& graph, const std::string& filename, bool localityOrder) {
+    return fromGraph(graph, localityOrder).save(filename);
+}
+
+bool GraphSnapshot::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error: Unable to open " << filename << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(header), static_cast<std::streamsize>(byteSize()));
+    if (!file) {
+        std::cerr << "Error: Unable to write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool GraphSnapshot::open(const std::string& filename, bool verifyChecksum) {
+    TraceSpan span("openSnapshot");
+    header = nullptr;
+    buffer.clear();
+    if (!file.open(filename)) {
+        std::cerr << "Error: Unable to open " << filename << std::endl;
+        return false;
+    }
+    if (verifyChecksum) file.advise(MappedFile::Access::Sequential);
+    return attach(file.data(), file.size(), verifyChecksum, filename);
+}
+
+bool GraphSnapshot::attach(const char* bytes, size_t size, bool verifyChecksum, const std::string& source) {
+    auto fail = [&](const char* reason) {
+        std::cerr << "Error: " << source << ": " << reason << std::endl;
+        header = nullptr;
+        return false;
+    };
+    if (size < sizeof(SnapshotHeader)) return fail("too small to be a graph snapshot");
+    const auto* head = sectionAt<SnapshotHeader>(bytes, 0);
+    if (std::memcmp(head->magic, MAGIC, sizeof(MAGIC)) != 0) return fail("not a graph snapshot");
+    if (head->version != VERSION) return fail("unsupported snapshot version");
+    if (head->headerSize != sizeof(SnapshotHeader) || head->fileSize != size) return fail("truncated snapshot");
+
+    uint64_t nodes64 = head->nodeCount, edges64 = head->edgeCount;
+    auto fits = [&](uint64_t offset, uint64_t bytes) { return offset % 8 == 0 && offset <= size && bytes <= size - offset; };
+    if (!fits(head->nodesOffset, nodes64 * sizeof(SnapshotNode)) ||
+        !fits(head->idIndexOffset, nodes64 * sizeof(SnapshotIdEntry)) ||
+        !fits(head->adjOffset, (nodes64 + 1) * sizeof(uint32_t)) ||
+        !fits(head->targetsOffset, edges64 * sizeof(uint32_t)) ||
+        !fits(head->drivingOffset, edges64 * sizeof(int32_t)) ||
+        !fits(head->walkingOffset, edges64 * sizeof(int32_t)) ||
+        !fits(head->stringsOffset, head->stringsSize)) {
+        return fail("section out of bounds");
+    }
+    if (verifyChecksum && hashBytes(bytes + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader)) != head->checksum) {
+        return fail("checksum mismatch");
+    }
+
+    header = head;
+    nodes = sectionAt<SnapshotNode>(bytes, head->nodesOffset);
+    idIndex = sectionAt<SnapshotIdEntry>(bytes, head->idIndexOffset);
+    adj = sectionAt<uint32_t>(bytes, head->adjOffset);
+    targets = sectionAt<uint32_t>(bytes, head->targetsOffset);
+    driving = sectionAt<int32_t>(bytes, head->drivingOffset);
+    walking = sectionAt<int32_t>(bytes, head->walkingOffset);
+    strings = sectionAt<char>(bytes, head->stringsOffset);
+    return true;
+}
+
+int GraphSnapshot::indexOf(int id) const {
+    const SnapshotIdEntry* end = idIndex + header->nodeCount;
+    const SnapshotIdEntry* it = std::lower_bound(idIndex, end, id,
+        [](const SnapshotIdEntry& entry, int value) { return entry.id < value; });
+    return it != end && it->id == id ? static_cast<int>(it->index) : -1;
+}
+
+void GraphSnapshot::toGraph(Graph* graph) const {
+    TraceSpan span("materializeGraph");
+    size_t first = graph->getLocations().size();
+    for (uint32_t i = 0; i < nodeCount(); ++i) {
+        graph->addLocation(nodeId(i), std::string(code(i)), hasParking(i));
+    }
+    const auto& locations = graph->getLocations();
+    for (uint32_t i = 0; i < nodeCount(); ++i) {
+        Location* origin = locations[first + i];
+        for (uint32_t e = edgesBegin(i); e < edgesEnd(i); ++e) {
+            origin->addRoad(new Road(origin, locations[first + target(e)], drivingTime(e), walkingTime(e)));
+        }
+    }
+}
+
+void GraphSnapshot::advise(MappedFile::Access access) const { file.advise(access); }
+
+void GraphSnapshot::reportMemory(MemoryReport& report) const {
+    if (!isOpen()) return;
+    auto backing = file.isOpen() && file.isMapped() ? MemoryReport::Backing::Mapped : MemoryReport::Backing::Heap;
+    size_t n = nodeCount(), m = edgeCount();
+    report.setShape(n, m);
+    report.add("snapshot", "nodes", n * sizeof(SnapshotNode), backing);
+    report.add("snapshot", "id index", n * sizeof(SnapshotIdEntry), backing);
+    report.add("snapshot", "adjacency", (n + 1 + m) * sizeof(uint32_t), backing);
+    report.add("snapshot", "weights", 2 * m * sizeof(int32_t), backing);
+    report.add("snapshot", "codes", static_cast<size_t>(header->stringsSize), backing);
+}
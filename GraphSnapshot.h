@@ -0,0 +1,189 @@
+/**
+* @file GraphSnapshot.h
+ * @brief Binary snapshot of a road network that loads by memory mapping
+ */
+
+#ifndef GRAPH_SNAPSHOT_H
+#define GRAPH_SNAPSHOT_H
+
+#include "Graph.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct SnapshotHeader
+ * @brief Fixed header at the start of a snapshot file
+ * @details All section offsets are in bytes from the start of the file and are
+ * 8-byte aligned. The checksum covers every byte after the header.
+ */
+struct SnapshotHeader {
+    char magic[8];           ///< "RTSNAP" followed by two zero bytes
+    uint32_t version;        ///< Format version, see GraphSnapshot::VERSION
+    uint32_t headerSize;     ///< sizeof(SnapshotHeader) when written
+    uint64_t checksum;       ///< GraphSnapshot::hashBytes of the payload
+    uint64_t fileSize;       ///< Total size of the file
+    uint32_t nodeCount;      ///< Number of locations
+    uint32_t edgeCount;      ///< Number of directed roads
+    uint64_t nodesOffset;    ///< SnapshotNode[nodeCount]
+    uint64_t idIndexOffset;  ///< SnapshotIdEntry[nodeCount], sorted by id
+    uint64_t adjOffset;      ///< uint32_t[nodeCount + 1], first road of each location
+    uint64_t targetsOffset;  ///< uint32_t[edgeCount], destination index of each road
+    uint64_t drivingOffset;  ///< int32_t[edgeCount], driving time (INF if not drivable)
+    uint64_t walkingOffset;  ///< int32_t[edgeCount], walking time
+    uint64_t stringsOffset;  ///< Location codes, concatenated
+    uint64_t stringsSize;    ///< Size of the code string pool
+};
+
+/**
+ * @struct SnapshotNode
+ * @brief Per-location record of the node table
+ */
+struct SnapshotNode {
+    int32_t id;            ///< Location ID
+    uint32_t codeOffset;   ///< Start of the code in the string pool
+    uint32_t codeLength;   ///< Length of the code
+    uint32_t flags;        ///< Bit 0: location has parking
+};
+
+/**
+ * @struct SnapshotIdEntry
+ * @brief Entry of the ID lookup table
+ */
+struct SnapshotIdEntry {
+    int32_t id;       ///< Location ID
+    uint32_t index;   ///< Position of the location in the node table
+};
+
+/**
+ * @class GraphSnapshot
+ * @brief Read-only, array-based view of a road network
+ * @details Locations are addressed by dense index, in the order of Graph::getLocations(),
+ * and the roads of each location are stored contiguously in adjacency order. A snapshot
+ * is either memory-mapped from a file, in which case nothing is parsed or copied, or
+ * built in memory from a Graph.
+ */
+class GraphSnapshot {
+public:
+    static constexpr uint32_t VERSION = 1;          ///< Current format version
+    static constexpr uint32_t PARKING_FLAG = 1u;    ///< SnapshotNode::flags bit for parking
+
+    GraphSnapshot() = default;
+
+    /**
+     * @brief Writes a snapshot of graph to a file.
+     * @param localityOrder Store locations in breadth-first order, see fromGraph().
+     * @return True on success.
+     * @complexity O(N log N + M) where N is the number of locations and M is the number of roads.
+     */
+    static bool write(const Graph& graph, const std::string& filename, bool localityOrder = false);
+
+    /**
+     * @brief Writes this snapshot to a file, so it can be opened later with the same checksum.
+     * @return True on success.
+     * @complexity O(S) where S is the size of the snapshot.
+     */
+    bool save(const std::string& filename) const;
+
+    /**
+     * @brief Builds an in-memory snapshot of graph.
+     * @param localityOrder Store locations in breadth-first order instead of graph order, so
+     * that neighbouring locations and their roads share pages when the snapshot is mapped.
+     * @complexity O(N log N + M) where N is the number of locations and M is the number of roads.
+     */
+    static GraphSnapshot fromGraph(const Graph& graph, bool localityOrder = false);
+
+    /**
+     * @brief Orders the locations breadth-first, one connected component after the other.
+     * @return The location indexes in visiting order.
+     * @complexity O(N + M) where N is the number of locations and M is the number of roads.
+     */
+    static std::vector<uint32_t> breadthFirstOrder(const GraphSnapshot& graph);
+
+    /**
+     * @brief Maps a snapshot file and validates its header.
+     * @param filename The snapshot file.
+     * @param verifyChecksum Also hash the payload and compare it with the header.
+     * @return True on success; errors are reported on cerr.
+     * @complexity O(1), or O(file size) when verifying the checksum.
+     */
+    bool open(const std::string& filename, bool verifyChecksum = true);
+
+    /**
+     * @brief Tells the kernel how the mapped snapshot is about to be accessed.
+     * @details Has no effect on in-memory snapshots.
+     */
+    void advise(MappedFile::Access access) const;
+
+    /**
+     * @brief Adds every location and road of the snapshot to an empty graph.
+     * @complexity O(N + M) where N is the number of locations and M is the number of roads.
+     */
+    void toGraph(Graph* graph) const;
+
+    /**
+     * @brief Hash used for snapshot checksums.
+     * @complexity O(N) where N is the number of bytes.
+     */
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+    bool isOpen() const { return header != nullptr; }
+    uint32_t nodeCount() const { return header->nodeCount; }
+    uint32_t edgeCount() const { return header->edgeCount; }
+    uint64_t checksum() const { return header->checksum; }
+    size_t byteSize() const { return static_cast<size_t>(header->fileSize); }
+
+    int nodeId(uint32_t node) const { return nodes[node].id; }
+    bool hasParking(uint32_t node) const { return nodes[node].flags & PARKING_FLAG; }
+    std::string_view code(uint32_t node) const { return {strings + nodes[node].codeOffset, nodes[node].codeLength}; }
+
+    /**
+     * @brief Finds the dense index of a location by ID.
+     * @return The index, or -1 if there is no such location.
+     * @complexity O(log N) where N is the number of locations.
+     */
+    int indexOf(int id) const;
+
+    uint32_t edgesBegin(uint32_t node) const { return adj[node]; }
+    uint32_t edgesEnd(uint32_t node) const { return adj[node + 1]; }
+    uint32_t target(uint32_t edge) const { return targets[edge]; }
+    int drivingTime(uint32_t edge) const { return driving[edge]; }
+    int walkingTime(uint32_t edge) const { return walking[edge]; }
+
+    /**
+     * @brief Calls visit(target, weight) for every road leaving node, in adjacency order.
+     * @param isDriving Selects driving times instead of walking times.
+     */
+    template <typename Visit>
+    void forEachEdge(uint32_t node, bool isDriving, Visit visit) const {
+        const int32_t* weights = isDriving ? driving : walking;
+        for (uint32_t e = adj[node]; e < adj[node + 1]; ++e) visit(targets[e], weights[e]);
+    }
+
+    /**
+     * @brief Adds the sections of the snapshot to a memory report, as mapped or heap bytes.
+     */
+    void reportMemory(MemoryReport& report) const;
+
+private:
+    /**
+     * @brief Points the section pointers into the given bytes after validating the layout.
+     */
+    bool attach(const char* bytes, size_t size, bool verifyChecksum, const std::string& source);
+
+    MappedFile file;                        ///< Backing mapping for file snapshots
+    std::vector<uint64_t> buffer;           ///< Backing storage for in-memory snapshots (8-byte aligned)
+    const SnapshotHeader* header = nullptr;
+    const SnapshotNode* nodes = nullptr;
+    const SnapshotIdEntry* idIndex = nullptr;
+    const uint32_t* adj = nullptr;
+    const uint32_t* targets = nullptr;
+    const int32_t* driving = nullptr;
+    const int32_t* walking = nullptr;
+    const char* strings = nullptr;
+};
+
+#endif // GRAPH_SNAPSHOT_H
@@ -0,0 +1,132 @@
+#include "IndexBundle.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+constexpr char MAGIC[8] = {'R', 'T', 'I', 'N', 'D', 'E', 'X', 0};
+
+/**
+ * @struct BundleHeader
+ * @brief Fixed header at the start of a bundle file, followed by the entry table
+ */
+struct BundleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t fileSize;
+};
+
+size_t alignUp(size_t value) { return (value + 7) & ~size_t(7); }
+
+void copyTag(char (&out)[8], std::string_view tag) {
+    std::memset(out, 0, sizeof(out));
+    std::memcpy(out, tag.data(), std::min(tag.size(), sizeof(out)));
+}
+
+} // namespace
+
+void IndexBundle::open(const std::string& bundleFile) {
+    filename = bundleFile;
+    loaded = false;
+    entries = nullptr;
+    entryCount = 0;
+    file.close();
+}
+
+bool IndexBundle::load() {
+    loaded = true;
+    if (filename.empty()) return false;
+    if (!file.open(filename)) {
+        std::cerr << "Warning: index bundle " << filename << " not found, using plain Dijkstra" << std::endl;
+        return false;
+    }
+    auto fail = [&](const char* reason) {
+        std::cerr << "Warning: index bundle " << filename << ": " << reason << ", using plain Dijkstra" << std::endl;
+        file.close();
+        return false;
+    };
+    if (file.size() < sizeof(BundleHeader)) return fail("truncated");
+    const auto* header = reinterpret_cast<const BundleHeader*>(file.data());
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) return fail("not an index bundle");
+    if (header->version != VERSION) return fail("unsupported bundle version");
+    if (header->fileSize != file.size() ||
+        header->entryCount > (file.size() - sizeof(BundleHeader)) / sizeof(IndexBundleEntry)) {
+        return fail("truncated");
+    }
+    const auto* table = reinterpret_cast<const IndexBundleEntry*>(file.data() + sizeof(BundleHeader));
+    for (uint32_t i = 0; i < header->entryCount; ++i) {
+        if (table[i].offset % 8 != 0 || table[i].offset > file.size() || table[i].size > file.size() - table[i].offset) {
+            return fail("index out of bounds");
+        }
+    }
+    entries = table;
+    entryCount = header->entryCount;
+    return true;
+}
+
+std::string_view IndexBundle::find(std::string_view tag, uint64_t graphChecksum) {
+    if (!loaded) load();
+    char key[8];
+    copyTag(key, tag);
+    bool stale = false;
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        const auto& entry = entries[i];
+        if (std::memcmp(entry.tag, key, sizeof(key)) != 0) continue;
+        if (entry.graphChecksum == graphChecksum && entry.metricVersion == METRIC_VERSION) {
+            return {file.data() + entry.offset, static_cast<size_t>(entry.size)};
+        }
+        stale = true;
+    }
+    if (stale) {
+        std::cerr << "Warning: " << tag << " index in " << filename
+                  << " was built for another graph or metric, using plain Dijkstra" << std::endl;
+    }
+    return {};
+}
+
+void IndexBundle::add(std::string_view tag, uint64_t graphChecksum, std::string payload) {
+    pending.push_back({std::string(tag), graphChecksum, std::move(payload)});
+}
+
+bool IndexBundle::write(const std::string& bundleFile) const {
+    BundleHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entryCount = static_cast<uint32_t>(pending.size());
+
+    std::vector<IndexBundleEntry> table(pending.size());
+    size_t offset = alignUp(sizeof(BundleHeader) + table.size() * sizeof(IndexBundleEntry));
+    for (size_t i = 0; i < pending.size(); ++i) {
+        copyTag(table[i].tag, pending[i].tag);
+        table[i].graphChecksum = pending[i].graphChecksum;
+        table[i].metricVersion = METRIC_VERSION;
+        table[i].offset = offset;
+        table[i].size = pending[i].payload.size();
+        offset = alignUp(offset + pending[i].payload.size());
+    }
+    header.fileSize = offset;
+
+    std::ofstream out(bundleFile, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: Unable to open " << bundleFile << std::endl;
+        return false;
+    }
+    static const char padding[8] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(IndexBundleEntry)));
+    size_t written = sizeof(header) + table.size() * sizeof(IndexBundleEntry);
+    for (size_t i = 0; i < pending.size(); ++i) {
+        out.write(padding, static_cast<std::streamsize>(table[i].offset - written));
+        out.write(pending[i].payload.data(), static_cast<std::streamsize>(pending[i].payload.size()));
+        written = table[i].offset + pending[i].payload.size();
+    }
+    out.write(padding, static_cast<std::streamsize>(offset - written));
+    if (!out) {
+        std::cerr << "Error: Unable to write " << bundleFile << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+/**
+* @file IndexBundle.h
+ * @brief On-disk container for preprocessed speedup indexes
+ */
+
+#ifndef INDEX_BUNDLE_H
+#define INDEX_BUNDLE_H
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct IndexBundleEntry
+ * @brief Table-of-contents entry describing one stored index
+ */
+struct IndexBundleEntry {
+    char tag[8];              ///< Index kind, e.g. "LANDMARK", zero padded
+    uint64_t graphChecksum;   ///< GraphSnapshot checksum of the graph the index was built for
+    uint32_t metricVersion;   ///< IndexBundle::METRIC_VERSION when the index was built
+    uint32_t reserved;        ///< Zero
+    uint64_t offset;          ///< Start of the payload, from the start of the file (8-byte aligned)
+    uint64_t size;            ///< Size of the payload
+};
+
+/**
+ * @class IndexBundle
+ * @brief Stores speedup indexes next to a graph snapshot so they are never rebuilt at startup
+ * @details Each index is tagged with the checksum of the graph and the version of the
+ * weight metric it was computed for. The file is only mapped the first time an index
+ * is requested, and a missing, damaged or stale index is reported as absent so callers
+ * can fall back to plain Dijkstra.
+ */
+class IndexBundle {
+public:
+    static constexpr uint32_t VERSION = 1;          ///< Container format version
+    static constexpr uint32_t METRIC_VERSION = 1;   ///< Bump when the meaning of road times changes
+
+    /**
+     * @brief Remembers the bundle file; nothing is read until find() is called.
+     */
+    void open(const std::string& filename);
+
+    /**
+     * @brief Looks up an index built for the given graph and the current metric.
+     * @param tag Index kind.
+     * @param graphChecksum Checksum of the graph being queried.
+     * @return A view of the payload inside the mapping, or an empty view if the
+     * index is missing or stale.
+     * @complexity O(K) where K is the number of indexes in the bundle.
+     */
+    std::string_view find(std::string_view tag, uint64_t graphChecksum);
+
+    /**
+     * @brief Adds a payload to be written by write().
+     */
+    void add(std::string_view tag, uint64_t graphChecksum, std::string payload);
+
+    /**
+     * @brief Writes every added payload to a bundle file.
+     * @return True on success.
+     */
+    bool write(const std::string& filename) const;
+
+private:
+    /**
+     * @brief Maps the file and validates the table of contents.
+     */
+    bool load();
+
+    struct PendingIndex {
+        std::string tag;
+        uint64_t graphChecksum;
+        std::string payload;
+    };
+
+    std::string filename;                   ///< Bundle path given to open()
+    bool loaded = false;                    ///< True once load() ran, successfully or not
+    MappedFile file;                        ///< Mapping of the bundle
+    const IndexBundleEntry* entries = nullptr;
+    uint32_t entryCount = 0;
+    std::vector<PendingIndex> pending;      ///< Payloads queued by add()
+};
+
+#endif // INDEX_BUNDLE_H
@@ -0,0 +1,82 @@
+#include "LandmarkIndex.h"
+#include "ArraySearch.h"
+#include "MemoryReport.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/**
+ * @struct LandmarkHeader
+ * @brief Start of a serialized landmark index, followed by the landmark list and the tables
+ */
+struct LandmarkHeader {
+    uint32_t nodeCount;
+    uint32_t landmarkCount;
+};
+
+size_t landmarkListBytes(uint32_t count) { return (count * sizeof(uint32_t) + 7) & ~size_t(7); }
+
+size_t payloadBytes(uint32_t nodeCount, uint32_t count) {
+    return sizeof(LandmarkHeader) + landmarkListBytes(count) + 2 * size_t(count) * nodeCount * sizeof(int32_t);
+}
+
+} // namespace
+
+LandmarkIndex LandmarkIndex::build(const GraphSnapshot& graph, uint32_t landmarkCount) {
+    TraceSpan span("buildLandmarks", "landmarks", landmarkCount);
+    uint32_t nodeCount = graph.nodeCount();
+    landmarkCount = std::min(landmarkCount, nodeCount);
+
+    LandmarkIndex index;
+    index.storage.assign((payloadBytes(nodeCount, landmarkCount) + 7) / 8, 0);
+    char* bytes = reinterpret_cast<char*>(index.storage.data());
+    auto* header = reinterpret_cast<LandmarkHeader*>(bytes);
+    auto* landmarks = reinterpret_cast<uint32_t*>(bytes + sizeof(LandmarkHeader));
+    auto* tables = reinterpret_cast<int32_t*>(bytes + sizeof(LandmarkHeader) + landmarkListBytes(landmarkCount));
+    header->nodeCount = nodeCount;
+    header->landmarkCount = landmarkCount;
+
+    ArraySearch<GraphSnapshot> search(graph);
+    std::vector<int> walking, driving;
+    // Farthest-point selection: each landmark is the location farthest from all previous
+    // ones; unreachable locations count as infinitely far so every component gets covered.
+    std::vector<int> nearest(nodeCount, INF);
+    uint32_t next = 0;
+    for (uint32_t l = 0; l < landmarkCount; ++l) {
+        TraceSpan landmark("landmarkTables", "landmark", next);
+        landmarks[l] = next;
+        search.distancesFrom(next, true, driving);
+        search.distancesFrom(next, false, walking);
+        std::memcpy(tables + size_t(l) * nodeCount, driving.data(), nodeCount * sizeof(int32_t));
+        std::memcpy(tables + (size_t(landmarkCount) + l) * nodeCount, walking.data(), nodeCount * sizeof(int32_t));
+        for (uint32_t v = 0; v < nodeCount; ++v) nearest[v] = std::min(nearest[v], walking[v]);
+        next = static_cast<uint32_t>(std::max_element(nearest.begin(), nearest.end()) - nearest.begin());
+    }
+
+    index.attach({bytes, payloadBytes(nodeCount, landmarkCount)}, nodeCount);
+    return index;
+}
+
+bool LandmarkIndex::attach(std::string_view payload, uint32_t nodeCount) {
+    if (payload.size() < sizeof(LandmarkHeader)) return false;
+    const auto* header = reinterpret_cast<const LandmarkHeader*>(payload.data());
+    if (header->nodeCount != nodeCount || payload.size() != payloadBytes(nodeCount, header->landmarkCount)) return false;
+    nodes = nodeCount;
+    count = header->landmarkCount;
+    landmarks = reinterpret_cast<const uint32_t*>(payload.data() + sizeof(LandmarkHeader));
+    tables = reinterpret_cast<const int32_t*>(payload.data() + sizeof(LandmarkHeader) + landmarkListBytes(count));
+    return true;
+}
+
+std::string LandmarkIndex::serialize() const {
+    const char* bytes = reinterpret_cast<const char*>(landmarks) - sizeof(LandmarkHeader);
+    return std::string(bytes, payloadBytes(nodes, count));
+}
+
+void LandmarkIndex::reportMemory(MemoryReport& report) const {
+    if (!isLoaded()) return;
+    if (!storage.empty()) report.add("landmarks", "tables", MemoryReport::vectorBytes(storage));
+    else report.add("landmarks", "tables", 2 * size_t(count) * nodes * sizeof(int32_t), MemoryReport::Backing::Mapped);
+}
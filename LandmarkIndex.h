@@ -0,0 +1,87 @@
+/**
+* @file LandmarkIndex.h
+ * @brief Landmark distance tables giving A* lower bounds (ALT)
+ */
+
+#ifndef LANDMARK_INDEX_H
+#define LANDMARK_INDEX_H
+
+#include "GraphSnapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class LandmarkIndex
+ * @brief Distances from a few landmark locations to every location, per travel mode
+ * @details By the triangle inequality |d(L, t) - d(L, v)| is a lower bound of d(v, t)
+ * for every landmark L. Roads are bidirectional with the same time both ways, so the
+ * bound is also consistent and A* with it settles each location at most once. Avoided
+ * locations and segments only remove roads, which keeps the bound valid.
+ *
+ * Tables are either built in memory or viewed in place inside an IndexBundle.
+ */
+class LandmarkIndex {
+public:
+    static constexpr const char* TAG = "LANDMARK";   ///< IndexBundle tag
+
+    LandmarkIndex() = default;
+    LandmarkIndex(const LandmarkIndex&) = delete;
+    LandmarkIndex& operator=(const LandmarkIndex&) = delete;
+    LandmarkIndex(LandmarkIndex&&) = default;
+    LandmarkIndex& operator=(LandmarkIndex&&) = default;
+
+    /**
+     * @brief Picks landmarks by farthest-point selection on walking times and computes their tables.
+     * @param landmarkCount Number of landmarks to place.
+     * @complexity O(K (N + M) log N) where K is the number of landmarks.
+     */
+    static LandmarkIndex build(const GraphSnapshot& graph, uint32_t landmarkCount);
+
+    /**
+     * @brief Views tables serialized by serialize(), without copying them.
+     * @return False if the payload does not match a graph of nodeCount locations.
+     */
+    bool attach(std::string_view payload, uint32_t nodeCount);
+
+    /**
+     * @brief Serializes the tables for storage in an IndexBundle.
+     */
+    std::string serialize() const;
+
+    bool isLoaded() const { return tables != nullptr; }
+    uint32_t landmarkCount() const { return count; }
+
+    /**
+     * @brief Adds the distance tables to a memory report; tables viewed in a bundle count as mapped.
+     */
+    void reportMemory(MemoryReport& report) const;
+
+    /**
+     * @brief Lower bound of the travel time between two locations.
+     * @param isDriving Selects the driving tables instead of the walking ones.
+     * @complexity O(K) where K is the number of landmarks.
+     */
+    int lowerBound(bool isDriving, uint32_t from, uint32_t to) const {
+        const int32_t* table = tables + (isDriving ? 0 : size_t(count) * nodes);
+        int bound = 0;
+        for (uint32_t l = 0; l < count; ++l, table += nodes) {
+            int a = table[from], b = table[to];
+            if (a == INF || b == INF) continue;
+            bound = std::max(bound, a > b ? a - b : b - a);
+        }
+        return bound;
+    }
+
+private:
+    uint32_t nodes = 0;                 ///< Number of locations
+    uint32_t count = 0;                 ///< Number of landmarks
+    const uint32_t* landmarks = nullptr;
+    const int32_t* tables = nullptr;    ///< [driving, walking][landmark][location]
+    std::vector<uint64_t> storage;      ///< Backing storage when built in memory (8-byte aligned)
+};
+
+#endif // LANDMARK_INDEX_H
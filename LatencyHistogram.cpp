@@ -0,0 +1,188 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+LatencyHistogram::LatencyHistogram() : counts(new std::atomic<uint64_t>[BUCKETS]) {
+    for (size_t i = 0; i < BUCKETS; ++i) counts[i].store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t value) {
+    // Magnitude m keeps the top SUB_BUCKET_BITS + 1 bits of the value: bucket = (m << S) + (value >> m)
+    unsigned width = 64 - static_cast<unsigned>(value ? __builtin_clzll(value) : 64);
+    unsigned magnitude = width > SUB_BUCKET_BITS + 1 ? width - (SUB_BUCKET_BITS + 1) : 0;
+    if (magnitude > MAX_MAGNITUDE - 1) return BUCKETS - 1;
+    return (size_t(magnitude) << SUB_BUCKET_BITS) + static_cast<size_t>(value >> magnitude);
+}
+
+uint64_t LatencyHistogram::upperEdge(size_t bucket) {
+    if (bucket < (size_t(2) << SUB_BUCKET_BITS)) return bucket;
+    unsigned magnitude = static_cast<unsigned>(bucket >> SUB_BUCKET_BITS) - 1;
+    uint64_t sub = bucket - (size_t(magnitude) << SUB_BUCKET_BITS);
+    return ((sub + 1) << magnitude) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    counts[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    if (nanoseconds > largest.load(std::memory_order_relaxed)) largest.store(nanoseconds, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        uint64_t n = other.counts[i].load(std::memory_order_relaxed);
+        if (n) counts[i].fetch_add(n, std::memory_order_relaxed);
+    }
+    total.fetch_add(other.count(), std::memory_order_relaxed);
+    sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    largest.store(std::max(max(), other.max()), std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? double(sum.load(std::memory_order_relaxed)) / double(n) : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * double(n) + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(upperEdge(i), max());
+    }
+    return max();
+}
+
+namespace {
+
+std::atomic<uint64_t> nextRecorderId{1};
+
+const char* const QUERY_TYPE_NAMES[] = {"normal", "restricted", "driving-walking"};
+
+} // namespace
+
+LatencyRecorder::LatencyRecorder() : id(nextRecorderId.fetch_add(1)) {}
+
+LatencyRecorder::~LatencyRecorder() = default;
+
+LatencyRecorder::Shard& LatencyRecorder::localShard() {
+    // (recorder id, shard) pairs of the calling thread; ids are never reused
+    static thread_local std::vector<std::pair<uint64_t, Shard*>> cache;
+    for (const auto& [owner, shard] : cache) {
+        if (owner == id) return *shard;
+    }
+    std::lock_guard<std::mutex> lock(registry);
+    if (shards.empty()) {
+        // Throughput and periodic reports count from the first query
+        started = std::chrono::steady_clock::now();
+        lastReport.store(started.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+    shards.push_back(std::make_unique<Shard>());
+    cache.emplace_back(id, shards.back().get());
+    return *shards.back();
+}
+
+void LatencyRecorder::record(const char* engine, int typeOfInput, std::chrono::nanoseconds latency) {
+    if (typeOfInput < 0 || typeOfInput >= QUERY_TYPES) return;
+    Shard& shard = localShard();
+    Series* series = nullptr;
+    for (const auto& candidate : shard.series) {
+        if (candidate->engine == engine) {
+            series = candidate.get();
+            break;
+        }
+    }
+    if (!series) {
+        std::lock_guard<std::mutex> lock(shard.growing);
+        shard.series.push_back(std::make_unique<Series>());
+        series = shard.series.back().get();
+        series->engine = engine;
+    }
+    series->types[typeOfInput].record(static_cast<uint64_t>(std::max<int64_t>(0, latency.count())));
+}
+
+std::vector<std::unique_ptr<LatencyRecorder::Series>> LatencyRecorder::merged(double& seconds) const {
+    std::vector<std::unique_ptr<Series>> result;
+    std::lock_guard<std::mutex> lock(registry);
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> growing(shard->growing);
+        for (const auto& series : shard->series) {
+            auto it = std::find_if(result.begin(), result.end(), [&](const std::unique_ptr<Series>& s) {
+                return std::strcmp(s->engine, series->engine) == 0;
+            });
+            if (it == result.end()) {
+                result.push_back(std::make_unique<Series>());
+                result.back()->engine = series->engine;
+                it = result.end() - 1;
+            }
+            for (int t = 0; t < QUERY_TYPES; ++t) (*it)->types[t].merge(series->types[t]);
+        }
+    }
+    return result;
+}
+
+void LatencyRecorder::writeText(std::ostream& out) const {
+    double seconds = 0;
+    auto all = merged(seconds);
+    auto micros = [](uint64_t ns) { return double(ns) / 1000.0; };
+    out << std::left << std::setw(12) << "engine" << std::setw(17) << "query" << std::right
+        << std::setw(12) << "count" << std::setw(12) << "qps" << std::setw(11) << "mean (us)"
+        << std::setw(11) << "p50 (us)" << std::setw(11) << "p99 (us)" << std::setw(12) << "p99.9 (us)"
+        << std::setw(11) << "max (us)" << '\n';
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& series : all) {
+        for (int t = 0; t < QUERY_TYPES; ++t) {
+            const LatencyHistogram& h = series->types[t];
+            if (h.count() == 0) continue;
+            out << std::left << std::setw(12) << series->engine << std::setw(17) << QUERY_TYPE_NAMES[t] << std::right
+                << std::setw(12) << h.count() << std::setw(12) << double(h.count()) / std::max(seconds, 1e-9)
+                << std::setw(11) << micros(static_cast<uint64_t>(h.mean()))
+                << std::setw(11) << micros(h.percentile(0.50)) << std::setw(11) << micros(h.percentile(0.99))
+                << std::setw(12) << micros(h.percentile(0.999)) << std::setw(11) << micros(h.max()) << '\n';
+        }
+    }
+    out.flags(flags);
+}
+
+void LatencyRecorder::writeCsv(std::ostream& out) const {
+    double seconds = 0;
+    auto all = merged(seconds);
+    out << "engine,query,count,seconds,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+    for (const auto& series : all) {
+        for (int t = 0; t < QUERY_TYPES; ++t) {
+            const LatencyHistogram& h = series->types[t];
+            if (h.count() == 0) continue;
+            out << series->engine << ',' << QUERY_TYPE_NAMES[t] << ',' << h.count() << ',' << seconds << ','
+                << static_cast<uint64_t>(h.mean()) << ',' << h.percentile(0.50) << ',' << h.percentile(0.90) << ','
+                << h.percentile(0.99) << ',' << h.percentile(0.999) << ',' << h.max() << '\n';
+        }
+    }
+}
+
+void LatencyRecorder::report() const {
+    writeText(std::cerr);
+    if (csvFile.empty()) return;
+    std::ofstream file(csvFile);
+    if (!file) {
+        std::cerr << "Error: Unable to open " << csvFile << std::endl;
+        return;
+    }
+    writeCsv(file);
+}
+
+void LatencyRecorder::reportPeriodically(std::chrono::seconds interval) {
+    if (interval.count() <= 0) return;
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    int64_t previous = lastReport.load(std::memory_order_relaxed);
+    int64_t period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval).count();
+    // Only the thread that advances lastReport writes the report
+    if (now - previous < period || !lastReport.compare_exchange_strong(previous, now, std::memory_order_relaxed)) return;
+    report();
+}
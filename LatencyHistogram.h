@@ -0,0 +1,146 @@
+/**
+* @file LatencyHistogram.h
+ * @brief Log-linear latency histograms recorded per thread and merged for reporting
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style histogram of nanosecond latencies with under 1% relative error
+ * @details Values below 256 ns have their own bucket; above that, each power of two is
+ * split into 128 buckets. Counters are relaxed atomics, so the owning thread records
+ * without locks while a reporter reads a consistent-enough copy at any time.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 7;                 ///< 128 buckets per power of two
+    static constexpr unsigned MAX_MAGNITUDE = 33;                  ///< Covers values up to 2^40 ns (about 18 minutes)
+    static constexpr size_t BUCKETS = (MAX_MAGNITUDE + 1) << SUB_BUCKET_BITS;
+
+    LatencyHistogram();
+
+    /**
+     * @brief Counts one latency; larger values than the range are clamped.
+     * @complexity O(1).
+     */
+    void record(uint64_t nanoseconds);
+
+    /**
+     * @brief Adds the counts of another histogram.
+     * @complexity O(B) where B is the number of buckets.
+     */
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return largest.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    /**
+     * @brief Smallest recorded value such that a fraction p of the values are not larger,
+     * reported as the upper edge of its bucket.
+     * @param p Fraction in [0, 1], e.g. 0.999 for p99.9.
+     * @complexity O(B) where B is the number of buckets.
+     */
+    uint64_t percentile(double p) const;
+
+private:
+    static size_t bucketOf(uint64_t value);
+    static uint64_t upperEdge(size_t bucket);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> largest{0};
+};
+
+/**
+ * @class LatencyRecorder
+ * @brief Latency histograms per engine and query type, kept per thread
+ * @details Each thread records into its own shard, found through a thread-local
+ * pointer, so recording takes no lock; the mutex is only taken when a thread records
+ * its first query and when a report merges the shards.
+ */
+class LatencyRecorder {
+public:
+    static constexpr int QUERY_TYPES = 3;   ///< TypeOfInput 0, 1 and 2
+
+    LatencyRecorder();
+    ~LatencyRecorder();
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    /**
+     * @brief Records one query.
+     * @param engine Name of the engine that answered it; must outlive the recorder.
+     * @param typeOfInput Query type, 0 to 2.
+     */
+    void record(const char* engine, int typeOfInput, std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Writes the merged histograms as a table: count, throughput, mean and percentiles.
+     */
+    void writeText(std::ostream& out) const;
+
+    /**
+     * @brief Writes the merged histograms as CSV, one row per engine and query type.
+     */
+    void writeCsv(std::ostream& out) const;
+
+    /**
+     * @brief Writes the text report to cerr and, if a file was set, rewrites the CSV file.
+     */
+    void report() const;
+
+    /**
+     * @brief Reports if at least interval has passed since the previous periodic report.
+     */
+    void reportPeriodically(std::chrono::seconds interval);
+
+    /**
+     * @brief Sets the CSV file rewritten by report().
+     */
+    void setCsvFile(const std::string& filename) { csvFile = filename; }
+
+private:
+    /**
+     * @struct Series
+     * @brief Histograms of one engine, one per query type
+     */
+    struct Series {
+        const char* engine;
+        LatencyHistogram types[QUERY_TYPES];
+    };
+
+    /**
+     * @struct Shard
+     * @brief Histograms recorded by one thread
+     */
+    struct Shard {
+        std::vector<std::unique_ptr<Series>> series;
+        std::mutex growing;   ///< Held while series is extended, so reporters see a complete vector
+    };
+
+    Shard& localShard();
+    std::vector<std::unique_ptr<Series>> merged(double& seconds) const;
+
+    mutable std::mutex registry;                  ///< Guards shards
+    std::vector<std::unique_ptr<Shard>> shards;   ///< One per recording thread
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();   ///< First query, guarded by registry
+    std::atomic<int64_t> lastReport{0};           ///< steady_clock ticks of the previous periodic report
+    std::string csvFile;
+    uint64_t id;                                  ///< Distinguishes recorders in the thread-local cache
+};
+
+#endif // LATENCY_HISTOGRAM_H
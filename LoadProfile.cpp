@@ -0,0 +1,105 @@
+#include "LoadProfile.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Restarts the peak resident memory from the current usage.
+ */
+void resetPeakResident() {
+#if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+} // namespace
+
+LoadProfile::Scope::Scope(LoadProfile* profile, const char* name) : profile(profile) {
+    if (!profile) return;
+    phase.name = name;
+    resetPeakResident();
+    start = std::chrono::steady_clock::now();
+}
+
+LoadProfile::Scope::~Scope() {
+    if (profile) finish();
+}
+
+void LoadProfile::Scope::next(const char* name) {
+    if (!profile) return;
+    finish();
+    phase = Phase();
+    phase.name = name;
+    resetPeakResident();
+    start = std::chrono::steady_clock::now();
+}
+
+void LoadProfile::Scope::finish() {
+    phase.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    phase.peakBytes = peakResidentBytes();
+    profile->finished.push_back(std::move(phase));
+}
+
+size_t LoadProfile::peakResidentBytes() {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::stoul(line.substr(6)) * 1024;
+    }
+    return 0;
+#elif !defined(_WIN32)
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+void LoadProfile::writeText(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    out << std::left << std::setw(18) << "phase" << std::right << std::setw(12) << "time (ms)" << std::setw(14)
+        << "bytes read" << std::setw(12) << "rows" << std::setw(10) << "rejected" << std::setw(14) << "peak (MiB)"
+        << '\n';
+    out << std::fixed;
+    Phase total;
+    total.name = "total";
+    for (const Phase& phase : finished) {
+        out << std::left << std::setw(18) << phase.name << std::right << std::setw(12) << std::setprecision(1)
+            << 1000 * phase.seconds << std::setw(14) << phase.bytesRead << std::setw(12) << phase.rowsParsed
+            << std::setw(10) << phase.rowsRejected << std::setw(14) << double(phase.peakBytes) / (1 << 20) << '\n';
+        total.seconds += phase.seconds;
+        total.bytesRead += phase.bytesRead;
+        total.rowsParsed += phase.rowsParsed;
+        total.rowsRejected += phase.rowsRejected;
+        total.peakBytes = std::max(total.peakBytes, phase.peakBytes);
+    }
+    out << std::left << std::setw(18) << total.name << std::right << std::setw(12) << 1000 * total.seconds
+        << std::setw(14) << total.bytesRead << std::setw(12) << total.rowsParsed << std::setw(10)
+        << total.rowsRejected << std::setw(14) << double(total.peakBytes) / (1 << 20) << '\n';
+    out.flags(flags);
+}
+
+void LoadProfile::writeJson(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    out << "{\"phases\":[" << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < finished.size(); ++i) {
+        const Phase& phase = finished[i];
+        out << (i ? "," : "") << "{\"name\":\"" << phase.name << "\",\"ms\":" << 1000 * phase.seconds
+            << ",\"bytes_read\":" << phase.bytesRead << ",\"rows_parsed\":" << phase.rowsParsed
+            << ",\"rows_rejected\":" << phase.rowsRejected << ",\"peak_bytes\":" << phase.peakBytes << '}';
+    }
+    out << "]}\n";
+    out.flags(flags);
+}
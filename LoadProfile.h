@@ -0,0 +1,93 @@
+/**
+* @file LoadProfile.h
+ * @brief Time, input and memory of each startup phase
+ */
+
+#ifndef LOAD_PROFILE_H
+#define LOAD_PROFILE_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class LoadProfile
+ * @brief Breakdown of loading and preprocessing into phases
+ * @details Each phase records its wall time, the bytes of input it read, the rows it
+ * parsed and rejected, and the peak resident memory of the process while it ran. On
+ * Linux the peak is reset at the start of every phase through /proc/self/clear_refs;
+ * where that is not possible it is the peak since the process started.
+ */
+class LoadProfile {
+public:
+    /**
+     * @struct Phase
+     * @brief Measurements of one finished phase
+     */
+    struct Phase {
+        std::string name;
+        double seconds = 0;
+        size_t bytesRead = 0;
+        size_t rowsParsed = 0;     ///< Non-empty rows read, rejected ones included
+        size_t rowsRejected = 0;
+        size_t peakBytes = 0;      ///< Peak resident memory, 0 if unknown
+    };
+
+    /**
+     * @class Scope
+     * @brief Measures one phase from construction to destruction
+     */
+    class Scope {
+    public:
+        /**
+         * @param profile Profile the phase is added to, or nullptr to measure nothing.
+         */
+        Scope(LoadProfile* profile, const char* name);
+        ~Scope();
+
+        /**
+         * @brief Ends the current phase and starts the next one.
+         */
+        void next(const char* name);
+
+        void addBytes(size_t bytes) { phase.bytesRead += bytes; }
+        void addRows(size_t parsed, size_t rejected) {
+            phase.rowsParsed += parsed;
+            phase.rowsRejected += rejected;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        void finish();
+
+        LoadProfile* profile;
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    const std::vector<Phase>& phases() const { return finished; }
+
+    /**
+     * @brief Writes one line per phase and the totals.
+     */
+    void writeText(std::ostream& out) const;
+
+    /**
+     * @brief Writes the phases as a JSON object.
+     */
+    void writeJson(std::ostream& out) const;
+
+    /**
+     * @brief Peak resident memory of the process, 0 if unknown.
+     */
+    static size_t peakResidentBytes();
+
+private:
+    std::vector<Phase> finished;
+};
+
+#endif // LOAD_PROFILE_H
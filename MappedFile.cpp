@@ -0,0 +1,110 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        buffer = std::move(other.buffer);
+        bytes = other.bytes;  // a moved vector keeps its storage
+        length = other.length;
+        mapped = other.mapped;
+        opened = other.opened;
+        other.bytes = nullptr;
+        other.length = 0;
+        other.mapped = false;
+        other.opened = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+#if !defined(_WIN32)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        bytes = static_cast<const char*>(addr);
+        mapped = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    length = static_cast<size_t>(file.tellg());
+    buffer.resize(length);
+    file.seekg(0);
+    file.read(buffer.data(), static_cast<std::streamsize>(length));
+    bytes = buffer.data();
+#endif
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+#if !defined(_WIN32)
+    if (mapped) munmap(const_cast<char*>(bytes), length);
+#endif
+    buffer.clear();
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    opened = false;
+}
+
+bool MappedFile::isOpen() const { return opened; }
+
+const char* MappedFile::data() const { return bytes; }
+
+size_t MappedFile::size() const { return length; }
+
+std::string_view MappedFile::view() const { return {bytes, length}; }
+
+void MappedFile::advise(Access access) const {
+#if !defined(_WIN32)
+    if (!mapped) return;
+    int advice = MADV_NORMAL;
+    if (access == Access::Sequential) advice = MADV_SEQUENTIAL;
+    else if (access == Access::Random) advice = MADV_RANDOM;
+    else if (access == Access::WillNeed) advice = MADV_WILLNEED;
+    madvise(const_cast<char*>(bytes), length, advice);
+#else
+    (void)access;
+#endif
+}
+
+PageFaults PageFaults::now() {
+    PageFaults faults;
+#if defined(RUSAGE_THREAD)
+    struct rusage usage{};
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) faults = {usage.ru_majflt, usage.ru_minflt};
+#elif !defined(_WIN32)
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) faults = {usage.ru_majflt, usage.ru_minflt};
+#endif
+    return faults;
+}
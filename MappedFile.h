@@ -0,0 +1,108 @@
+/**
+* @file MappedFile.h
+ * @brief Read-only memory mapping of input files
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class MappedFile
+ * @brief Maps a whole file read-only into memory
+ * @details Uses mmap on POSIX systems and falls back to reading the file into
+ * an owned buffer elsewhere. The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Expected access pattern, passed to the kernel as a paging hint.
+     */
+    enum class Access { Normal, Sequential, Random, WillNeed };
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Maps the given file, releasing any previous mapping.
+     * @param filename Path of the file to map.
+     * @return True on success, false if the file could not be opened or mapped.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Releases the mapping.
+     */
+    void close();
+
+    /**
+     * @brief Check if a file is currently mapped.
+     * @return True if mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Check if the bytes are mmapped rather than read into an owned buffer.
+     */
+    bool isMapped() const { return mapped; }
+
+    /**
+     * @brief Get the first byte of the mapping.
+     * @return Pointer to the mapped bytes, or nullptr for an empty file.
+     */
+    const char* data() const;
+
+    /**
+     * @brief Get the size of the mapping.
+     * @return Size in bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the whole file as a string view.
+     * @return View over the mapped bytes.
+     */
+    std::string_view view() const;
+
+    /**
+     * @brief Advises the kernel of the coming access pattern (madvise).
+     * @details Sequential suits whole-file passes such as checksums and preprocessing,
+     * Random suits point-to-point queries. No effect when the file is not mmapped.
+     */
+    void advise(Access access) const;
+
+private:
+    const char* bytes = nullptr;   ///< Start of the mapped region
+    size_t length = 0;             ///< Size of the mapped region
+    bool mapped = false;           ///< True if bytes comes from mmap
+    bool opened = false;           ///< True once open() succeeded
+    std::vector<char> buffer;      ///< Owned copy when mmap is unavailable
+};
+
+/**
+ * @struct PageFaults
+ * @brief Page fault counters of the calling thread
+ * @details Major faults needed disk I/O; minor faults were served from the page cache.
+ */
+struct PageFaults {
+    long major = 0;   ///< Faults that read from disk
+    long minor = 0;   ///< Faults served without I/O
+
+    /**
+     * @brief Reads the current counters (zero where getrusage is unavailable).
+     */
+    static PageFaults now();
+
+    PageFaults operator-(const PageFaults& earlier) const { return {major - earlier.major, minor - earlier.minor}; }
+};
+
+#endif // MAPPED_FILE_H
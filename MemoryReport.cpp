@@ -0,0 +1,55 @@
+#include "MemoryReport.h"
+#include <algorithm>
+#include <iomanip>
+
+void MemoryReport::add(const std::string& component, const std::string& part, size_t bytes, Backing backing) {
+    parts.push_back({component, part, bytes, backing});
+}
+
+void MemoryReport::setShape(size_t nodeCount, size_t edgeCount) {
+    nodes = nodeCount;
+    edges = edgeCount;
+}
+
+size_t MemoryReport::heapBytes() const {
+    size_t total = 0;
+    for (const auto& p : parts) if (p.backing == Backing::Heap) total += p.bytes;
+    return total;
+}
+
+size_t MemoryReport::mappedBytes() const {
+    size_t total = 0;
+    for (const auto& p : parts) if (p.backing == Backing::Mapped) total += p.bytes;
+    return total;
+}
+
+size_t MemoryReport::allocation(size_t bytes) {
+    // glibc: an 8-byte size header, 16-byte alignment and a 32-byte minimum chunk
+    return std::max<size_t>(32, (bytes + 8 + 15) & ~size_t(15));
+}
+
+size_t MemoryReport::stringBytes(const std::string& text) {
+    // Inline capacity of the small-string buffer (15 characters in libstdc++ and MSVC)
+    static const size_t inlineCapacity = std::string().capacity();
+    return text.capacity() > inlineCapacity ? allocation(text.capacity() + 1) : 0;
+}
+
+void MemoryReport::writeText(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    auto line = [&](const std::string& component, const std::string& part, size_t bytes, const char* backing) {
+        out << std::left << std::setw(12) << component << std::setw(18) << part << std::setw(8) << backing << std::right
+            << std::setw(14) << bytes << std::setw(10) << std::setprecision(1) << double(bytes) / (1 << 20)
+            << std::setw(10) << double(bytes) / double(std::max<size_t>(nodes, 1))
+            << std::setw(10) << double(bytes) / double(std::max<size_t>(edges, 1)) << '\n';
+    };
+    out << "Memory: " << nodes << " locations, " << edges << " directed roads\n";
+    out << std::left << std::setw(12) << "component" << std::setw(18) << "part" << std::setw(8) << "backing"
+        << std::right << std::setw(14) << "bytes" << std::setw(10) << "MiB" << std::setw(10) << "B/node"
+        << std::setw(10) << "B/edge" << '\n';
+    out << std::fixed;
+    for (const auto& p : parts) line(p.component, p.part, p.bytes, p.backing == Backing::Heap ? "heap" : "mapped");
+    line("total", "", heapBytes(), "heap");
+    line("total", "", mappedBytes(), "mapped");
+    line("total", "", heapBytes() + mappedBytes(), "");
+    out.flags(flags);
+}
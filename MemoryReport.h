@@ -0,0 +1,86 @@
+/**
+* @file MemoryReport.h
+ * @brief Explicit byte accounting of the road network, the engines and their workspaces
+ */
+
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class MemoryReport
+ * @brief Bytes held by each part of each component, with bytes per location and per road
+ * @details Components add their own parts (see Graph::reportMemory and friends). Heap
+ * parts are estimated from capacities and include the allocator's per-block overhead;
+ * mapped parts are file pages shared with the page cache, which the kernel can evict.
+ */
+class MemoryReport {
+public:
+    enum class Backing { Heap, Mapped };
+
+    /**
+     * @brief Adds one part of a component.
+     */
+    void add(const std::string& component, const std::string& part, size_t bytes, Backing backing = Backing::Heap);
+
+    /**
+     * @brief Sets the size of the road network the per-location and per-road figures refer to.
+     * @param edges Number of directed roads.
+     */
+    void setShape(size_t nodes, size_t edges);
+
+    size_t heapBytes() const;
+    size_t mappedBytes() const;
+
+    /**
+     * @brief Writes one line per part and the heap, mapped and overall totals.
+     */
+    void writeText(std::ostream& out) const;
+
+    /**
+     * @brief Size of the heap block malloc uses for a request, header and alignment included.
+     */
+    static size_t allocation(size_t bytes);
+
+    /**
+     * @brief Heap bytes of a string beyond the object itself; short strings are stored inline.
+     */
+    static size_t stringBytes(const std::string& text);
+
+    template <typename T>
+    static size_t vectorBytes(const std::vector<T>& items) {
+        return items.capacity() ? allocation(items.capacity() * sizeof(T)) : 0;
+    }
+
+    /**
+     * @brief Heap bytes of a node-based hash table: the bucket array and one block per element.
+     */
+    template <typename HashTable>
+    static size_t hashTableBytes(const HashTable& table) {
+        // Each node holds the next pointer, the element and the cached hash code
+        size_t node = allocation(sizeof(void*) + sizeof(typename HashTable::value_type) + sizeof(size_t));
+        return allocation(table.bucket_count() * sizeof(void*)) + table.size() * node;
+    }
+
+private:
+    /**
+     * @struct Part
+     * @brief One line of the report
+     */
+    struct Part {
+        std::string component;
+        std::string part;
+        size_t bytes;
+        Backing backing;
+    };
+
+    std::vector<Part> parts;
+    size_t nodes = 0;
+    size_t edges = 0;
+};
+
+#endif // MEMORY_REPORT_H
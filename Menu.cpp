@@ -4,84 +4,323 @@
  */
 
 #include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <mutex>
 #include <vector>
 #include <limits>
 
+#include "AllPairsTable.h"
 #include "FileManager.h"
 #include "Graph.h"
+#include "GraphSnapshot.h"
+#include "IndexBundle.h"
+#include "LandmarkIndex.h"
+#include "LatencyHistogram.h"
+#include "LoadProfile.h"
+#include "MemoryReport.h"
+#include "PathTreeCache.h"
+#include "PerfCounters.h"
+#include "QueryLog.h"
+#include "RequestParser.h"
+#include "ResultReader.h"
+#include "ResultWriter.h"
+#include "RouteCache.h"
+#include "RoutePlanner.h"
+#include "RouteSubscriptions.h"
+#include "SearchEngine.h"
+#include "Trace.h"
+#include <memory>
 using namespace std;
 
 //Global data structures
 Graph* RoadMap = new Graph;  ///< Adjacency list representing the road network
+GraphSnapshot Snapshot;      ///< Array view of the road network, mapped by --snapshot or built on demand
+IndexBundle Indexes;         ///< Preprocessed speedup indexes given with --index-bundle
+LandmarkIndex Landmarks;     ///< Landmark tables viewed inside Indexes
+CompressedGraph Compressed;  ///< Compressed adjacency, built when --compressed is given
+bool UseCompressed = false;  ///< Answer queries from the compressed adjacency
+AllPairsTable AllPairs;      ///< Distances and routes between every two locations, for small networks
+uint32_t AllPairsLimit = 2048;  ///< Largest network given all-pairs tables, set with --all-pairs-limit
+bool WriteStats = false;     ///< Write the search statistics of each query with its result
+bool RecordLatency = false;  ///< Keep latency histograms of the answered queries
+LatencyRecorder Latencies;   ///< Latency histograms per engine and query type
+chrono::seconds LatencyInterval{0};  ///< Period of the latency reports, 0 for a report at exit only
+bool CountHardware = false;  ///< Read the hardware performance counters around each search phase
+PerfProfile HardwareCounters;  ///< Hardware event totals per engine and phase
+string TraceFile;            ///< Chrome trace written at exit, if set with --trace
+bool ProfileLoad = false;    ///< Measure the loading and preprocessing phases
+LoadProfile LoadPhases;      ///< Phases measured when ProfileLoad is set
+string LoadProfileFile;      ///< JSON file of the load phases, if set with --load-profile-json
+QueryCapture Capture;        ///< Query log recorded with --capture
+unique_ptr<RouteCache> Cache;  ///< Results of recent batch and server queries, kept with --cache
+unique_ptr<PathTreeCache> Trees;  ///< Shortest path trees of frequent sources, kept with --tree-cache
+unique_ptr<RouteSubscriptions> Subscriptions;  ///< Standing routes of the server, created by the first subscribe request
+RouteSubscriptions::Network SubscribedNetwork;  ///< Network the subscriptions are computed on, see subscriptionNetwork()
+volatile sig_atomic_t MemoryReportRequested = 0;  ///< Set by SIGUSR1, served between queries
+bool OutOfCore = false;      ///< Answer queries straight from the mapped snapshot, without building RoadMap
+PageFaults QueryFaults;      ///< Page faults of the batch and server queries in out-of-core mode
+long MostQueryMajorFaults = 0;  ///< Largest number of major faults of one of those queries
+uint64_t FaultedQueries = 0; ///< Queries counted in QueryFaults
+unique_ptr<SearchEngine> Router;  ///< Engine answering the planners' shortest-path queries
 
 /**
- * @brief Handles normal route planning.
+ * @brief Returns the array view of the road network, building it if no snapshot was loaded.
 */
-void planNormalRoute() {
-    Input input = FileManager::readInputFile("input.txt", 0);
-    Output output;
-    output.sourceId = input.sourceId;
-    output.destId = input.destId;
-    output.TypeOfInput = 0;
-    if (input.sourceId == -1 || input.destId == -1) {
-        cerr << "Error: Invalid input file format.\n";
-        return;
-    }
-    if (!RoadMap->findLocation(input.sourceId) || !RoadMap->findLocation(input.destId)) {
-        cerr << "Error: Invalid Source or Destination ID.\n";
-        return;
+const GraphSnapshot& snapshot() {
+    if (!Snapshot.isOpen()) Snapshot = GraphSnapshot::fromGraph(*RoadMap);
+    return Snapshot;
+}
+
+/**
+ * @brief Returns the engine used by the planners, choosing it on first use.
+ * @details Uses A* with landmarks when the index bundle holds tables for this graph,
+ * then the compressed adjacency if requested, and falls back to plain Dijkstra on the
+ * graph otherwise. Networks of at most AllPairsLimit locations get all-pairs tables that
+ * answer every unrestricted search; otherwise, with a path tree cache, the engine is
+ * wrapped so searches from frequent sources are answered from their trees.
+*/
+SearchEngine& router() {
+    if (!Router) {
+        string_view payload = Indexes.find(LandmarkIndex::TAG, snapshot().checksum());
+        if (!payload.empty() && Landmarks.attach(payload, Snapshot.nodeCount())) {
+            Router = make_unique<SnapshotEngine>(Snapshot, &Landmarks);
+        } else if (UseCompressed) {
+            Compressed = CompressedGraph::build(Snapshot);
+            cerr << "Compressed adjacency: " << Compressed.adjacencyBytes() << " bytes ("
+                 << double(Compressed.adjacencyBytes()) / max<size_t>(Compressed.edgeCount(), 1)
+                 << " bytes per road)" << endl;
+            Router = make_unique<CompressedEngine>(Compressed);
+        } else if (OutOfCore) {
+            Router = make_unique<SnapshotEngine>(Snapshot);
+        } else {
+            Router = make_unique<ReferenceEngine>(*RoadMap);
+        }
+        if (Snapshot.nodeCount() <= min(AllPairsLimit, AllPairsTable::MAX_NODES)) {
+            AllPairs = AllPairsTable::build(Snapshot);
+            cerr << "All-pairs tables: " << AllPairs.nodeCount() << " locations, " << AllPairs.bytes() << " bytes" << endl;
+            Router = make_unique<AllPairsEngine>(std::move(Router), Snapshot, AllPairs);
+        } else if (Trees) {
+            Router = make_unique<TreeCachedEngine>(std::move(Router), Snapshot, *Trees);
+        }
     }
-    output.bestPath = RoadMap->dijkstra(input.sourceId, input.destId, true, input.avoidNodes,input.avoidSegments);
-    if (output.bestPath.first.size() > 1) {
-        output.altPath = RoadMap->dijkstra(input.sourceId, input.destId, true, input.avoidNodes, input.avoidSegments);
+    return *Router;
+}
+
+/**
+ * @brief Runs one RoutePlanner function with the current engine, recording its latency if requested.
+ * @return The planner's result.
+*/
+bool timedSolve(bool (*solve)(SearchEngine&, Input&, Output&), Input& input, Output& output) {
+    if (Capture.active()) Capture.record(input);
+    SearchEngine& engine = router();
+    PerfProfile::Scope counting(CountHardware ? &HardwareCounters : nullptr, engine.name());
+    auto start = chrono::steady_clock::now();
+    bool answered = solve(engine, input, output);
+    if (RecordLatency) {
+        Latencies.record(engine.name(), output.TypeOfInput, chrono::steady_clock::now() - start);
+        Latencies.reportPeriodically(LatencyInterval);
     }
-    FileManager::writeOutputFile("output.txt", output);
-    input.avoidSegments.clear();
+    return answered;
+}
 
+/**
+ * @brief Runs a result writing call, counted as the output phase of the current engine.
+*/
+template <typename Write>
+void profiledOutput(Write write) {
+    PerfProfile::Scope counting(CountHardware ? &HardwareCounters : nullptr, router().name());
+    PerfPhase phase(PerfProfile::Output);
+    TraceSpan span("writeOutput");
+    write();
 }
 
 /**
- * @brief Handles restricted route planning.
+ * @brief Closes the query log and writes the reports requested on the command line to cerr.
 */
-void planRestrictedRoute() {
-    Input input = FileManager::readInputFile("input.txt", 1);
-    Output output;
-    output.TypeOfInput = 1;
-    output.sourceId = input.sourceId;
-    output.destId = input.destId;
-    if (input.sourceId == -1 || input.destId == -1) {
-        cerr << "Error: Invalid input file format.\n";
+void reportMeasurements() {
+    if (Capture.active()) Capture.stop();
+    if (Cache) Cache->writeText(cerr);
+    if (Trees) Trees->writeText(cerr);
+    if (Subscriptions) Subscriptions->writeText(cerr);
+    if (FaultedQueries > 0) {
+        cerr << "Page faults in " << FaultedQueries << " out-of-core queries: " << QueryFaults.major << " major, "
+             << QueryFaults.minor << " minor (" << double(QueryFaults.major) / double(FaultedQueries) << " major and "
+             << double(QueryFaults.minor) / double(FaultedQueries) << " minor per query, at most "
+             << MostQueryMajorFaults << " major in one query)" << endl;
+    }
+    if (RecordLatency) Latencies.report();
+    if (CountHardware) HardwareCounters.writeText(cerr);
+    if (!TraceFile.empty()) Trace::write(TraceFile);
+}
+
+/**
+ * @brief Writes the load phases as JSON to LoadProfileFile, or as a table on cerr.
+*/
+void reportLoadProfile() {
+    if (LoadProfileFile.empty()) {
+        LoadPhases.writeText(cerr);
         return;
     }
-    if (!RoadMap->findLocation(input.sourceId) || !RoadMap->findLocation(input.destId)) {
-        cerr << "Error: Invalid Source or Destination ID.\n";
+    if (LoadProfileFile == "-") {
+        LoadPhases.writeJson(cout);
         return;
     }
+    ofstream file(LoadProfileFile);
+    if (file) LoadPhases.writeJson(file);
+    else cerr << "Error: Unable to open " << LoadProfileFile << endl;
+}
 
-    if (input.includeNodeId != -1) {
-        auto firstHalf = RoadMap->dijkstra(input.sourceId, input.includeNodeId, true, input.avoidNodes, input.avoidSegments);
-        if (firstHalf.first.empty()) {
-            FileManager::writeOutputFile("output.txt", output);
-            return;
-        }
+/**
+ * @brief Writes the memory used by the road network, the indexes and the engine.
+*/
+void reportMemory(ostream& out) {
+    MemoryReport report;
+    if (!RoadMap->getLocations().empty()) RoadMap->reportMemory(report);
+    Snapshot.reportMemory(report);
+    Landmarks.reportMemory(report);
+    if (Compressed.nodeCount() > 0) Compressed.reportMemory(report);
+    if (AllPairs.nodeCount() > 0) AllPairs.reportMemory(report);
+    if (Router) Router->reportMemory(report);
+    if (Cache) Cache->reportMemory(report);
+    if (Trees) Trees->reportMemory(report);
+    report.writeText(out);
+}
 
-        auto secondHalf = RoadMap->dijkstra(input.includeNodeId, input.destId, true, input.avoidNodes, input.avoidSegments);
-        if (secondHalf.first.empty()) {
-            FileManager::writeOutputFile("output.txt", output);
-            return;
+/**
+ * @brief Writes the memory report on cerr if SIGUSR1 asked for one since the last query.
+*/
+void serveMemoryReportRequest() {
+    if (!MemoryReportRequested) return;
+    MemoryReportRequested = 0;
+    reportMemory(cerr);
+}
+
+/**
+ * @brief Answers a query from the route cache, or with the planners and caches the result.
+*/
+bool cachedSolve(SearchEngine& engine, Input& input, Output& output) {
+    // The key is taken first, as the planners extend the avoided segments
+    uint64_t key = RouteCache::fingerprint(input);
+    if (Cache->lookup(key, output)) return true;
+    if (!RoutePlanner::solve(engine, input, output)) return false;
+    Cache->insert(key, output);
+    return true;
+}
+
+/**
+ * @brief Computes the answer to a query of any mode with the current engine.
+ * @details In out-of-core mode the page faults of the query are added to QueryFaults.
+ * @return False if the query is invalid or has no answer; the reason is printed on cerr.
+*/
+bool solveQuery(Input& input, Output& output) {
+    if (!OutOfCore) return timedSolve(Cache ? cachedSolve : RoutePlanner::solve, input, output);
+    PageFaults before = PageFaults::now();
+    bool answered = timedSolve(Cache ? cachedSolve : RoutePlanner::solve, input, output);
+    PageFaults faults = PageFaults::now() - before;
+    QueryFaults.major += faults.major;
+    QueryFaults.minor += faults.minor;
+    MostQueryMajorFaults = max(MostQueryMajorFaults, faults.major);
+    ++FaultedQueries;
+    return answered;
+}
+
+/**
+ * @brief Locations settled around each end of a faster road to re-validate the cached routes and subscriptions.
+ */
+constexpr size_t REVALIDATION_LIMIT = 4096;
+
+/**
+ * @brief Drops the cached results and path trees that a road's new time in one mode can change.
+ * @details A closed or slower road only affects the entries whose routes or tree edges take it.
+ * A faster road is checked against every entry with the distance bounds of the change.
+*/
+void updateCaches(const RoadChange& change) {
+    // The rebuilt snapshot lists the locations in the same order as the one the trees were built on
+    if (Trees && Trees->treeCount() > 0) {
+        Trees->roadChanged(snapshot(), change.fromId, change.toId, change.isDriving, change.oldTime, change.newTime);
+    }
+    if (!Cache) return;
+    if (change.newTime > change.oldTime) Cache->invalidateRoad(change.fromId, change.toId, change.isDriving);
+    else Cache->revalidateFasterRoad(change.newTime, change.isDriving, change.nearFrom, change.nearTo);
+}
+
+/**
+ * @brief Returns an array view of RoadMap owned by the subscriptions, rebuilt after road updates.
+ * @details In out-of-core mode the mapped snapshot never changes and is shared instead.
+*/
+RouteSubscriptions::Network subscriptionNetwork() {
+    if (OutOfCore) return RouteSubscriptions::Network(&Snapshot, [](const GraphSnapshot*) {});
+    static uint64_t builtAt = 0;
+    if (!SubscribedNetwork || builtAt != RoadMap->version()) {
+        SubscribedNetwork = make_shared<const GraphSnapshot>(GraphSnapshot::fromGraph(*RoadMap));
+        builtAt = RoadMap->version();
+    }
+    return SubscribedNetwork;
+}
+
+/**
+ * @brief Changes a road of RoadMap and drops everything derived from the old network.
+ * @details The array view, compressed adjacency, all-pairs tables and engine are rebuilt on the next query.
+ * Landmark tables from an index bundle no longer match the graph's checksum and stay unused.
+ * Only the cached results and path trees the new times can change are dropped, and only
+ * the subscriptions they can change are recomputed.
+ * @return False with error set if the update cannot be applied.
+ * @complexity O(D) where D is the degree of the two locations, plus O(N + M) on the next query,
+ * or O(N (N + M) log N) when the network gets all-pairs tables.
+*/
+bool applyRoadUpdate(int fromId, int toId, const RoadUpdate& update, const char*& error) {
+    if (OutOfCore) {
+        error = "road updates need the graph in memory";
+        return false;
+    }
+    int oldDriving = RoadMap->roadTime(fromId, toId, true), oldWalking = RoadMap->roadTime(fromId, toId, false);
+    if (!RoadMap->updateRoad(fromId, toId, update.drivingTime, update.walkingTime)) {
+        error = "no road between these locations";
+        return false;
+    }
+    Router.reset();
+    Snapshot = GraphSnapshot();
+    Compressed = CompressedGraph();
+    AllPairs = AllPairsTable();
+    Landmarks = LandmarkIndex();
+    vector<RoadChange> changes;
+    for (bool isDriving : {true, false}) {
+        int oldTime = isDriving ? oldDriving : oldWalking;
+        int newTime = isDriving ? update.drivingTime : update.walkingTime;
+        if (newTime < 0 || newTime == oldTime) continue;
+        RoadChange change{fromId, toId, isDriving, oldTime, newTime, Neighbourhood(), Neighbourhood()};
+        if (isDriving && newTime < oldTime && (Cache || Subscriptions)) {
+            change.nearFrom = RoadMap->neighbourhood(fromId, true, REVALIDATION_LIMIT);
+            change.nearTo = RoadMap->neighbourhood(toId, true, REVALIDATION_LIMIT);
         }
+        updateCaches(change);
+        changes.push_back(std::move(change));
+    }
+    if (Subscriptions) Subscriptions->roadUpdated(RoadMap->version(), changes, subscriptionNetwork);
+    return true;
+}
 
-        // Merge paths (remove duplicate includeNodeId)
-        std::vector<int> fullPath = firstHalf.first;
-        fullPath.pop_back(); // remove includeNode from the first half
-        fullPath.insert(fullPath.end(), secondHalf.first.begin(), secondHalf.first.end());
-        output.bestPath.first = fullPath;
-        output.bestPath.second = firstHalf.second + secondHalf.second; //Sum of times
-        FileManager::writeOutputFile("output.txt", output);
+/**
+ * @brief Handles normal route planning.
+*/
+void planNormalRoute() {
+    Input input = FileManager::readInputFile("input.txt", 0);
+    Output output;
+    if (timedSolve(RoutePlanner::solveNormalRoute, input, output)) {
+        profiledOutput([&] { FileManager::writeOutputFile("output.txt", output, WriteStats); });
     }
-    else {
-        output.bestPath = RoadMap->dijkstra(input.sourceId, input.destId, true, input.avoidNodes, input.avoidSegments);
-        FileManager::writeOutputFile("output.txt", output);
+}
+
+/**
+ * @brief Handles restricted route planning.
+*/
+void planRestrictedRoute() {
+    Input input = FileManager::readInputFile("input.txt", 1);
+    Output output;
+    if (timedSolve(RoutePlanner::solveRestrictedRoute, input, output)) {
+        profiledOutput([&] { FileManager::writeOutputFile("output.txt", output, WriteStats); });
     }
 }
 
@@ -91,43 +330,136 @@ void planRestrictedRoute() {
 void planEnvironmentallyFriendlyRoute() {
     Input input = FileManager::readInputFile("input.txt", 0);
     Output output;
-    output.TypeOfInput = 2;
-    output.sourceId = input.sourceId;
-    output.destId = input.destId;
-    output.maxWalkingTime = input.maxWalkingTime;
+    if (timedSolve(RoutePlanner::solveEnvironmentallyFriendlyRoute, input, output)) {
+        profiledOutput([&] { FileManager::writeOutputFile("output.txt", output, WriteStats); });
+    }
+}
 
-    if (input.sourceId == -1 || input.destId == -1 || input.maxWalkingTime == -1) {
-        cerr << "Error: Invalid environmentally-friendly input file format.\n";
-        return;
+/**
+ * @brief Answers every query of a batch file, appending the results to one destination.
+ * @details Text results use the output.txt format and are separated by blank lines. Queries
+ * without an answer are reported on cerr with their position and skipped.
+ * @param outputFile Destination file, or "-" for stdout.
+ * @param format Text, or the compact binary stream read by ResultReader.
+ * @return True if the results were written.
+ * @complexity O(Q) route searches where Q is the number of queries.
+*/
+bool runBatch(const string& queryFile, const string& outputFile, ResultWriter::Format format) {
+    vector<Input> queries = FileManager::loadQueries(queryFile);
+    ResultWriter writer;
+    if (!writer.open(outputFile, false, format)) return false;
+    writer.includeStats(WriteStats);
+    size_t answered = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        serveMemoryReportRequest();
+        Output output;
+        if (!solveQuery(queries[i], output)) {
+            cerr << "Warning: query " << i + 1 << " skipped" << endl;
+            continue;
+        }
+        profiledOutput([&] {
+            if (answered++ > 0) writer.write("\n");
+            writer.write(output);
+        });
     }
+    cerr << "Batch: " << answered << " of " << queries.size() << " queries answered" << endl;
+    return writer.close();
+}
 
-    auto [drivePath, walkPath, parkingNode, totalTime, walkingTime, suggestions] = RoadMap->EnvironmentallyFriendlyRoute(
-        input.sourceId, input.destId, input.maxWalkingTime, input.avoidNodes, input.avoidSegments);
-    if (!drivePath.empty() && !walkPath.empty() && parkingNode != -1) {
-        output.bestPath.first = drivePath;
-        output.altPath.first = walkPath;
-        output.bestPath.second = totalTime - walkingTime;
-        output.altPath.second = walkingTime;
-        output.parkingNode = parkingNode;
-        output.totalTime = totalTime;
-
-    } else if(!suggestions.empty()){
-        output.bestPath.first = suggestions[0].drivePath;
-        output.altPath.first = suggestions[0].walkPath;
-        output.bestPath.second = suggestions[0].totalTime - suggestions[0].walkingTime;
-        output.altPath.second = suggestions[0].walkingTime;
-        output.parkingNode = suggestions[0].parkingNode;
-        output.totalTime = suggestions[0].totalTime;
-        output.hasSuggestions = true;
-        output.suggestions = suggestions;
-
-    }   else{
-        cerr << "No feasible environmentally-friendly route found.\n";
-        return;
+/**
+ * @brief Answers JSON Lines requests from stdin until it is closed.
+ * @details Each line holds one request (see RequestParser) and gets exactly one response
+ * line on stdout, in request order. Responses are flushed whenever no further input is
+ * already buffered, so a supervising process can pipeline requests or send them one by one.
+ * A road update request changes RoadMap and is answered with the graph's new version.
+ * A subscribe request is answered with its subscription number; the results of the
+ * subscription are then pushed, between responses, whenever they change.
+ * @complexity O(Q) route searches where Q is the number of requests.
+*/
+void runServer() {
+    ios::sync_with_stdio(false);
+    ResultWriter writer;
+    writer.open("-", false, ResultWriter::Format::Json);
+    writer.includeStats(WriteStats);
+    mutex outputGuard;   // Pushes are written by the subscription worker
+    string line;   // Reused, so steady-state reading does not allocate
+    Input input;
+    Output output;
+    RoadUpdate update;
+    SubscriptionRequest subscription;
+    while (getline(cin, line)) {
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        string_view id;
+        const char* error = nullptr;
+        bool parsed = RequestParser::parse(line, input, id, error, &update, &subscription);
+        if (parsed && subscription.subscribe) {
+            if (!Subscriptions) {
+                Subscriptions = make_unique<RouteSubscriptions>([&](uint64_t number, uint64_t version, const Output* result) {
+                    lock_guard<mutex> lock(outputGuard);
+                    writer.writeJsonPush(number, version, result);
+                    writer.flush();
+                });
+            }
+            uint64_t number = Subscriptions->subscribe(input, subscriptionNetwork(), RoadMap->version());
+            {
+                // The reply goes out before the worker can push the first result
+                lock_guard<mutex> lock(outputGuard);
+                writer.writeJsonSubscription(id, number);
+            }
+            Subscriptions->activate(number);
+        } else if (parsed && input.TypeOfInput == RequestParser::UNSUBSCRIBE) {
+            bool cancelled = Subscriptions && Subscriptions->unsubscribe(subscription.subscription);
+            lock_guard<mutex> lock(outputGuard);
+            if (cancelled) writer.writeJsonSubscription(id, subscription.subscription);
+            else writer.writeJsonError(id, "no such subscription");
+        } else if (parsed && input.TypeOfInput == RequestParser::ROAD_UPDATE) {
+            bool applied = applyRoadUpdate(input.sourceId, input.destId, update, error);
+            lock_guard<mutex> lock(outputGuard);
+            if (applied) writer.writeJsonVersion(id, RoadMap->version());
+            else writer.writeJsonError(id, error);
+        } else if (parsed) {
+            output.hasSuggestions = false;
+            output.suggestions.clear();
+            output.bestPath.first.clear();
+            output.altPath.first.clear();
+            bool answered = solveQuery(input, output);
+            lock_guard<mutex> lock(outputGuard);
+            profiledOutput([&] {
+                if (answered) writer.writeJson(output, id);
+                else writer.writeJsonError(id, "no route for this query");
+            });
+        } else {
+            lock_guard<mutex> lock(outputGuard);
+            writer.writeJsonError(id, error);
+        }
+        if (cin.rdbuf()->in_avail() <= 0) {
+            lock_guard<mutex> lock(outputGuard);
+            writer.flush();
+        }
+        serveMemoryReportRequest();
     }
+    if (Subscriptions) Subscriptions->finish();
+    writer.close();
+}
 
-    
-    FileManager::writeOutputFile("output.txt", output);
+/**
+ * @brief Decodes a binary result file and prints it in the output.txt format on stdout.
+ * @return True if the whole file was decoded.
+ * @complexity O(S) where S is the size of the file.
+*/
+bool printResults(const string& filename) {
+    ResultReader reader;
+    if (!reader.open(filename)) return false;
+    ResultWriter writer;
+    writer.open("-");
+    Output output;
+    for (size_t count = 0; reader.next(output); ++count) {
+        if (count > 0) writer.write("\n");
+        writer.write(output);
+    }
+    writer.close();
+    if (reader.failed()) cerr << "Error: " << filename << " has a corrupt record" << endl;
+    return !reader.failed();
 }
 
 /**
@@ -135,8 +467,50 @@ void planEnvironmentallyFriendlyRoute() {
  * @complexity O(N + M) where N is the number of locations and M is the number of roads.
 */
 void loadData() {
-    FileManager::loadLocations("LocSample.txt", RoadMap);
-    FileManager::loadDistances("DisSample.txt", RoadMap);
+    LoadProfile* profile = ProfileLoad ? &LoadPhases : nullptr;
+    FileManager::loadLocations("LocSample.txt", RoadMap, profile);
+    FileManager::loadDistances("DisSample.txt", RoadMap, 0, profile);
+}
+
+/**
+ * @brief Loads the road network from a binary snapshot instead of the CSV files.
+ * @param materialize Also build RoadMap; out-of-core mode only keeps the mapping.
+ * @return True if the snapshot was valid.
+ * @complexity O(N + M) where N is the number of locations and M is the number of roads.
+*/
+bool loadSnapshot(const string& filename, bool materialize) {
+    LoadProfile::Scope phase(ProfileLoad ? &LoadPhases : nullptr, "open snapshot");
+    if (!Snapshot.open(filename)) return false;
+    phase.addBytes(Snapshot.byteSize()); // The checksum reads the whole file
+    if (materialize) {
+        phase.next("materialize graph");
+        Snapshot.toGraph(RoadMap);
+    }
+    return true;
+}
+
+/**
+ * @brief Runs a planner, reporting its page faults in out-of-core mode.
+*/
+void runPlanner(void (*planner)()) {
+    PageFaults before = PageFaults::now();
+    planner();
+    if (OutOfCore) {
+        PageFaults faults = PageFaults::now() - before;
+        cout << "Page faults: " << faults.major << " major, " << faults.minor << " minor" << endl;
+    }
+}
+
+/**
+ * @brief Precomputes the speedup indexes for the loaded graph and writes them to a bundle.
+ * @return True if the bundle was written.
+ * @complexity O(K (N + M) log N) where K is the number of landmarks.
+*/
+bool writeIndexBundle(const string& filename, uint32_t landmarkCount) {
+    const GraphSnapshot& graph = snapshot();
+    IndexBundle bundle;
+    bundle.add(LandmarkIndex::TAG, graph.checksum(), LandmarkIndex::build(graph, landmarkCount).serialize());
+    return bundle.write(filename);
 }
 
 /**
@@ -148,32 +522,163 @@ void showMenu() {
     cout << "2. Plan Restricted Route (Avoid Nodes/Segments)" << endl;
     cout << "3. Plan Environmentally Friendly Route (driving + walking)" << endl;
     cout << "4. Exit" << endl;
+    cout << "5. Show Memory Usage" << endl;
     cout << "Enter your choice: ";
 }
 
-int main() {
-    loadData();
+int main(int argc, char* argv[]) {
+    string snapshotFile, writeSnapshotFile, writeBundleFile, batchFile, batchOutputFile = "-", resultsFile;
+    ResultWriter::Format batchFormat = ResultWriter::Format::Text;
+    uint32_t landmarkCount = 16;
+    bool localityOrder = false, serve = false, memoryReport = false;
+    double treeCacheMiB = 0;
+    uint32_t treeAdmit = 2;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--snapshot" && i + 1 < argc) snapshotFile = argv[++i];
+        else if (arg == "--write-snapshot" && i + 1 < argc) writeSnapshotFile = argv[++i];
+        else if (arg == "--index-bundle" && i + 1 < argc) Indexes.open(argv[++i]);
+        else if (arg == "--write-index-bundle" && i + 1 < argc) writeBundleFile = argv[++i];
+        else if (arg == "--landmarks" && i + 1 < argc) landmarkCount = static_cast<uint32_t>(stoul(argv[++i]));
+        else if (arg == "--batch" && i + 1 < argc) batchFile = argv[++i];
+        else if (arg == "--batch-output" && i + 1 < argc) batchOutputFile = argv[++i];
+        else if (arg == "--batch-format" && i + 1 < argc && (argv[i + 1] == string("text") || argv[i + 1] == string("binary") || argv[i + 1] == string("json"))) {
+            string format = argv[++i];
+            batchFormat = format == "binary" ? ResultWriter::Format::Binary
+                        : format == "json" ? ResultWriter::Format::Json : ResultWriter::Format::Text;
+        }
+        else if (arg == "--serve") serve = true;
+        else if (arg == "--stats") WriteStats = true;
+        else if (arg == "--latency-report") RecordLatency = true;
+        else if (arg == "--latency-csv" && i + 1 < argc) {
+            RecordLatency = true;
+            Latencies.setCsvFile(argv[++i]);
+        }
+        else if (arg == "--latency-interval" && i + 1 < argc) {
+            RecordLatency = true;
+            LatencyInterval = chrono::seconds(stol(argv[++i]));
+        }
+        else if (arg == "--perf-counters") CountHardware = true;
+        else if (arg == "--memory-report") memoryReport = true;
+        else if (arg == "--load-profile") ProfileLoad = true;
+        else if (arg == "--cache" && i + 1 < argc) Cache = make_unique<RouteCache>(stoul(argv[++i]));
+        else if (arg == "--tree-cache" && i + 1 < argc) treeCacheMiB = stod(argv[++i]);
+        else if (arg == "--tree-admit" && i + 1 < argc) treeAdmit = static_cast<uint32_t>(stoul(argv[++i]));
+        else if (arg == "--capture" && i + 1 < argc) {
+            if (!Capture.start(argv[++i])) return 1;
+        }
+        else if (arg == "--load-profile-json" && i + 1 < argc) {
+            ProfileLoad = true;
+            LoadProfileFile = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            TraceFile = argv[++i];
+            Trace::start();
+        }
+        else if (arg == "--print-results" && i + 1 < argc) resultsFile = argv[++i];
+        else if (arg == "--compressed") UseCompressed = true;
+        else if (arg == "--all-pairs-limit" && i + 1 < argc) AllPairsLimit = static_cast<uint32_t>(stoul(argv[++i]));
+        else if (arg == "--out-of-core") OutOfCore = true;
+        else if (arg == "--locality-order") localityOrder = true;
+        else {
+            cerr << "Usage: " << argv[0] << " [--snapshot <file> [--out-of-core]]"
+                 << " [--write-snapshot <file> [--locality-order]]"
+                 << " [--index-bundle <file>] [--write-index-bundle <file> [--landmarks <count>]]"
+                 << " [--compressed] [--all-pairs-limit <locations>] [--batch <queries.csv> [--batch-output <file>] [--batch-format text|binary|json]]"
+                 << " [--print-results <file>] [--serve] [--stats]"
+                 << " [--latency-report] [--latency-csv <file>] [--latency-interval <seconds>]"
+                 << " [--perf-counters] [--trace <file>] [--memory-report]"
+                 << " [--load-profile] [--load-profile-json <file>] [--capture <query log>]"
+                 << " [--cache <entries>] [--tree-cache <MiB> [--tree-admit <searches>]]" << endl;
+            return 1;
+        }
+    }
+    if (treeCacheMiB > 0) Trees = make_unique<PathTreeCache>(static_cast<size_t>(treeCacheMiB * 1024 * 1024), treeAdmit);
+    if (WriteStats && !SearchStats::enabled()) {
+        cerr << "Warning: built without ROUTE_SEARCH_STATS, search statistics will be zero.\n";
+    }
+    if (!resultsFile.empty()) {
+        delete RoadMap;
+        return printResults(resultsFile) ? 0 : 1;
+    }
+    if (OutOfCore && snapshotFile.empty()) {
+        cerr << "Error: --out-of-core needs --snapshot.\n";
+        return 1;
+    }
+
+    if (snapshotFile.empty()) loadData();
+    else if (!loadSnapshot(snapshotFile, !OutOfCore || !writeSnapshotFile.empty())) return 1;
+
+    if (!writeSnapshotFile.empty() || !writeBundleFile.empty()) {
+        bool written = true;
+        if (!writeSnapshotFile.empty()) {
+            // The index bundle is built on the snapshot written, so it carries the same checksum
+            Snapshot = GraphSnapshot::fromGraph(*RoadMap, localityOrder);
+            written = Snapshot.save(writeSnapshotFile);
+        }
+        if (!writeBundleFile.empty()) written = writeIndexBundle(writeBundleFile, landmarkCount) && written;
+        if (ProfileLoad) reportLoadProfile();
+        if (!TraceFile.empty()) Trace::write(TraceFile);
+        delete RoadMap;
+        return written ? 0 : 1;
+    }
+
+    if (OutOfCore || ProfileLoad) {
+        LoadProfile::Scope phase(ProfileLoad ? &LoadPhases : nullptr, "preprocess");
+        // Preprocessing streams through the file; queries then touch scattered pages
+        if (OutOfCore) Snapshot.advise(MappedFile::Access::Sequential);
+        router();
+        if (OutOfCore) Snapshot.advise(MappedFile::Access::Random);
+    }
+    if (ProfileLoad) reportLoadProfile();
+
+    if (memoryReport) {
+        router();
+        reportMemory(cerr);
+    }
+#ifdef SIGUSR1
+    signal(SIGUSR1, [](int) { MemoryReportRequested = 1; });
+#endif
+
+    if (!batchFile.empty()) {
+        bool written = runBatch(batchFile, batchOutputFile, batchFormat);
+        reportMeasurements();
+        delete RoadMap;
+        return written ? 0 : 1;
+    }
+
+    if (serve) {
+        runServer();
+        reportMeasurements();
+        delete RoadMap;
+        return 0;
+    }
+
     int choice;
     do {
         showMenu();
         cin >> choice;
         switch (choice) {
             case 1:
-                planNormalRoute();
+                runPlanner(planNormalRoute);
             break;
             case 2:
-               planRestrictedRoute();
+               runPlanner(planRestrictedRoute);
             break;
             case 3:
-                planEnvironmentallyFriendlyRoute();
+                runPlanner(planEnvironmentallyFriendlyRoute);
             break;
             case 4:
                 cout << "Exiting program." << endl;
             break;
+            case 5:
+                reportMemory(cout);
+            break;
             default:
                 cout << "Invalid choice. Please enter a valid option." << endl;
         }
     } while (choice != 4);
+    reportMeasurements();
     delete RoadMap;
     return 0;
 }
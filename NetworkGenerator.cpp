@@ -0,0 +1,151 @@
+#include "NetworkGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+/**
+ * @class Random
+ * @brief splitmix64, so generated graphs do not depend on the standard library
+ */
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    /** Uniform in [0, 1). */
+    double unit() { return double(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    /** Uniform in [low, high]. */
+    int between(int low, int high) { return low + static_cast<int>(next() % uint64_t(high - low + 1)); }
+
+private:
+    uint64_t state;
+};
+
+constexpr double UNDRIVABLE_SHARE = 0.03; ///< Share of local roads that are footpaths
+
+void addLocations(Graph* graph, uint32_t count, double parkingDensity, Random& random) {
+    const int first = static_cast<int>(graph->getLocations().size()) + 1;
+    for (uint32_t i = 0; i < count; ++i) {
+        int id = first + static_cast<int>(i);
+        graph->addLocation(id, "G" + std::to_string(id), random.unit() < parkingDensity);
+    }
+}
+
+/**
+ * @brief Adds a local road of the given driving time, possibly a footpath.
+ */
+void addLocalRoad(Graph* graph, uint32_t from, uint32_t to, int drivingTime, Random& random) {
+    const auto& locations = graph->getLocations();
+    int walkingTime = drivingTime * random.between(4, 6);
+    if (random.unit() < UNDRIVABLE_SHARE) drivingTime = INF;
+    graph->addRoad(locations[from], locations[to], drivingTime, walkingTime);
+}
+
+/**
+ * @brief Adds a grid of roads over the locations [first, first + rows * columns).
+ */
+void addGridRoads(Graph* graph, uint32_t first, uint32_t rows, uint32_t columns, Random& random) {
+    for (uint32_t r = 0; r < rows; ++r) {
+        for (uint32_t c = 0; c < columns; ++c) {
+            uint32_t node = first + r * columns + c;
+            if (c + 1 < columns) addLocalRoad(graph, node, node + 1, random.between(1, 10), random);
+            if (r + 1 < rows) addLocalRoad(graph, node, node + columns, random.between(1, 10), random);
+        }
+    }
+}
+
+} // namespace
+
+void NetworkGenerator::grid(Graph* graph, uint32_t rows, uint32_t columns, double parkingDensity, uint64_t seed) {
+    Random random(seed);
+    uint32_t first = static_cast<uint32_t>(graph->getLocations().size());
+    addLocations(graph, rows * columns, parkingDensity, random);
+    addGridRoads(graph, first, rows, columns, random);
+}
+
+void NetworkGenerator::randomGeometric(Graph* graph, uint32_t nodes, double averageDegree, double parkingDensity, uint64_t seed) {
+    Random random(seed);
+    uint32_t first = static_cast<uint32_t>(graph->getLocations().size());
+    addLocations(graph, nodes, parkingDensity, random);
+
+    std::vector<std::pair<double, double>> points(nodes);
+    for (auto& point : points) point = {random.unit(), random.unit()};
+
+    // Expected neighbours within radius r: N * pi * r^2
+    const double radius = std::sqrt(averageDegree / (3.141592653589793 * std::max<uint32_t>(nodes, 1)));
+    const uint32_t cells = std::max<uint32_t>(1, static_cast<uint32_t>(1.0 / radius));
+    auto cellOf = [&](double coordinate) { return std::min(cells - 1, static_cast<uint32_t>(coordinate * cells)); };
+
+    // Bucket the points by cell so only the neighbouring cells are compared
+    std::vector<uint32_t> cellStart(size_t(cells) * cells + 1, 0), members(nodes);
+    for (const auto& point : points) ++cellStart[size_t(cellOf(point.second)) * cells + cellOf(point.first) + 1];
+    for (size_t i = 1; i < cellStart.size(); ++i) cellStart[i] += cellStart[i - 1];
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (uint32_t i = 0; i < nodes; ++i) {
+        members[fill[size_t(cellOf(points[i].second)) * cells + cellOf(points[i].first)]++] = i;
+    }
+
+    for (uint32_t i = 0; i < nodes; ++i) {
+        uint32_t cx = cellOf(points[i].first), cy = cellOf(points[i].second);
+        for (uint32_t y = cy > 0 ? cy - 1 : 0; y <= std::min(cells - 1, cy + 1); ++y) {
+            for (uint32_t x = cx > 0 ? cx - 1 : 0; x <= std::min(cells - 1, cx + 1); ++x) {
+                size_t cell = size_t(y) * cells + x;
+                for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                    uint32_t j = members[k];
+                    if (j <= i) continue; // Each pair once
+                    double dx = points[i].first - points[j].first, dy = points[i].second - points[j].second;
+                    double distance = std::sqrt(dx * dx + dy * dy);
+                    if (distance > radius) continue;
+                    int drivingTime = 1 + static_cast<int>(9.0 * distance / radius);
+                    addLocalRoad(graph, first + i, first + j, drivingTime, random);
+                }
+            }
+        }
+    }
+}
+
+void NetworkGenerator::hierarchical(Graph* graph, uint32_t cities, uint32_t cityNodes, double parkingDensity, uint64_t seed) {
+    Random random(seed);
+    const uint32_t side = std::max<uint32_t>(1, static_cast<uint32_t>(std::sqrt(double(cityNodes))));
+    const uint32_t first = static_cast<uint32_t>(graph->getLocations().size());
+    addLocations(graph, cities * side * side, parkingDensity, random);
+    for (uint32_t city = 0; city < cities; ++city) addGridRoads(graph, first + city * side * side, side, side, random);
+
+    const auto& locations = graph->getLocations();
+    auto centre = [&](uint32_t city) { return locations[first + city * side * side + (side / 2) * side + side / 2]; };
+    auto addHighway = [&](uint32_t a, uint32_t b) {
+        // Long enough to cross a city, but about five times faster than local roads
+        graph->addRoad(centre(a), centre(b), random.between(side, 2 * side), INF);
+    };
+    if (cities > 1) {
+        for (uint32_t city = 0; city < cities; ++city) addHighway(city, (city + 1) % cities);
+        for (uint32_t shortcut = 0; shortcut < cities / 2; ++shortcut) {
+            uint32_t a = static_cast<uint32_t>(random.next() % cities), b = static_cast<uint32_t>(random.next() % cities);
+            if (a != b) addHighway(a, b);
+        }
+    }
+}
+
+bool NetworkGenerator::generate(Graph* graph, const std::string& kind, uint32_t nodes, double parkingDensity, uint64_t seed) {
+    if (kind == "grid") {
+        uint32_t side = std::max<uint32_t>(1, static_cast<uint32_t>(std::sqrt(double(nodes))));
+        grid(graph, side, side, parkingDensity, seed);
+    } else if (kind == "geometric") {
+        randomGeometric(graph, nodes, 6.0, parkingDensity, seed);
+    } else if (kind == "hierarchical") {
+        uint32_t cities = std::max<uint32_t>(1, static_cast<uint32_t>(std::sqrt(double(nodes)) / 4));
+        hierarchical(graph, cities, std::max<uint32_t>(1, nodes / cities), parkingDensity, seed);
+    } else {
+        return false;
+    }
+    return true;
+}
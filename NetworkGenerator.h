@@ -0,0 +1,54 @@
+/**
+* @file NetworkGenerator.h
+ * @brief Deterministic synthetic road networks for benchmarking
+ */
+
+#ifndef NETWORK_GENERATOR_H
+#define NETWORK_GENERATOR_H
+
+#include "Graph.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @class NetworkGenerator
+ * @brief Builds grid, random geometric and hierarchical road networks
+ * @details The same parameters always give the same graph, on any platform: random
+ * numbers come from a fixed splitmix64 sequence. Locations get IDs 1..N and codes "G<id>",
+ * and each one has parking with probability parkingDensity. Walking takes four to six
+ * times longer than driving, and a small share of local roads cannot be driven.
+ */
+class NetworkGenerator {
+public:
+    /**
+     * @brief A rows x columns grid with roads between horizontal and vertical neighbours.
+     * @complexity O(N) where N is rows * columns.
+     */
+    static void grid(Graph* graph, uint32_t rows, uint32_t columns, double parkingDensity, uint64_t seed);
+
+    /**
+     * @brief Locations scattered uniformly in a square, with roads between every pair
+     * closer than the radius giving the requested average number of roads per location.
+     * @details Times are proportional to distance. The graph may be disconnected.
+     * @complexity O(N * D) on average where D is the average degree.
+     */
+    static void randomGeometric(Graph* graph, uint32_t nodes, double averageDegree, double parkingDensity, uint64_t seed);
+
+    /**
+     * @brief Square grid cities joined by a ring of fast highways plus random shortcuts.
+     * @details Highways link city centres, can be driven about five times faster than
+     * local roads and cannot be walked.
+     * @complexity O(N) where N is cities * cityNodes.
+     */
+    static void hierarchical(Graph* graph, uint32_t cities, uint32_t cityNodes, double parkingDensity, uint64_t seed);
+
+    /**
+     * @brief Builds a network of about the given size by generator name.
+     * @param kind "grid", "geometric" or "hierarchical".
+     * @return False for an unknown kind.
+     */
+    static bool generate(Graph* graph, const std::string& kind, uint32_t nodes, double parkingDensity, uint64_t seed);
+};
+
+#endif // NETWORK_GENERATOR_H
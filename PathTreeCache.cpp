@@ -0,0 +1,219 @@
+#include "PathTreeCache.h"
+#include "MemoryReport.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+/**
+ * @brief Requests between two halvings of the request counts.
+ */
+constexpr uint64_t AGING_PERIOD = 4096;
+
+} // namespace
+
+void PackedArray::assign(const std::vector<uint32_t>& values) {
+    uint32_t largest = values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+    width = 1;
+    while (width < 32 && (largest >> width) != 0) ++width;
+    mask = (uint64_t(1) << width) - 1;
+    // One spare word lets operator[] read a value straddling the last boundary
+    words.assign((values.size() * width + 63) / 64 + 1, 0);
+    for (size_t i = 0; i < values.size(); ++i) {
+        size_t bit = i * width;
+        size_t word = bit >> 6;
+        unsigned offset = bit & 63;
+        words[word] |= uint64_t(values[i]) << offset;
+        if (offset + width > 64) words[word + 1] |= uint64_t(values[i]) >> (64 - offset);
+    }
+    words.shrink_to_fit();
+}
+
+size_t PackedArray::bytes() const {
+    return MemoryReport::vectorBytes(words);
+}
+
+PathTree PathTree::build(const GraphSnapshot& network, uint32_t source, bool isDriving) {
+    std::vector<int> distances;
+    std::vector<uint32_t> parents;
+    ArraySearch<GraphSnapshot>(network).distancesFrom(source, isDriving, distances, &parents);
+    std::vector<uint32_t> stored(distances.size());
+    for (size_t node = 0; node < distances.size(); ++node) {
+        stored[node] = distances[node] == INF ? 0 : static_cast<uint32_t>(distances[node]) + 1;
+    }
+    PathTree tree;
+    tree.source = source;
+    tree.isDriving = isDriving;
+    tree.distances.assign(stored);
+    tree.parents.assign(parents);
+    return tree;
+}
+
+std::pair<std::vector<int>, int> PathTree::route(const GraphSnapshot& network, uint32_t destination,
+                                                 std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) const {
+    uint32_t stored = distances[destination];
+    if (stored == 0) return {};
+    std::vector<int> path;
+    uint32_t node = destination;
+    path.push_back(network.nodeId(node));
+    while (node != source) {
+        uint32_t previous = parents[node];
+        blockedSegments.insert({network.nodeId(previous), network.nodeId(node)});
+        node = previous;
+        path.push_back(network.nodeId(node));
+    }
+    std::reverse(path.begin(), path.end());
+    return {path, static_cast<int>(stored - 1)};
+}
+
+bool PathTree::affectedBy(uint32_t a, uint32_t b, int oldTime, int newTime) const {
+    if (newTime > oldTime) {
+        return (parents[b] == a && b != source && distances[b] != 0) || (parents[a] == b && a != source && distances[a] != 0);
+    }
+    auto improves = [&](uint32_t from, uint32_t to) {
+        uint32_t before = distances[from], after = distances[to];
+        if (before == 0) return false;
+        if (after == 0) return true;
+        int64_t through = int64_t(before - 1) + newTime;
+        return through < int64_t(after - 1) || (through == int64_t(after - 1) && parents[to] != from);
+    };
+    return newTime < oldTime && (improves(a, b) || improves(b, a));
+}
+
+PathTreeCache::PathTreeCache(size_t budgetBytes, uint32_t admitAfter)
+    : budget(budgetBytes), admitAfter(std::max<uint32_t>(1, admitAfter)) {}
+
+std::shared_ptr<const PathTree> PathTreeCache::acquire(const GraphSnapshot& network, uint32_t source, bool isDriving) {
+    uint64_t key = keyOf(source, isDriving);
+    uint32_t count;
+    {
+        std::lock_guard<std::mutex> lock(guard);
+        ++totals.requests;
+        if (++sinceAging == AGING_PERIOD) {
+            sinceAging = 0;
+            for (auto it = frequency.begin(); it != frequency.end();) {
+                if ((it->second >>= 1) == 0) it = frequency.erase(it);
+                else ++it;
+            }
+        }
+        count = ++frequency[key];
+        auto it = trees.find(key);
+        if (it != trees.end()) {
+            ++totals.hits;
+            return it->second;
+        }
+        if (count < admitAfter) return nullptr;
+        // Only build if a tree like the last ones could be kept
+        size_t expected = trees.empty() ? 0 : used / trees.size();
+        if (used + expected > budget && !makeRoom(expected, count)) return nullptr;
+    }
+
+    // Built without the lock; a tree another thread built meanwhile is kept instead
+    auto tree = std::make_shared<const PathTree>(PathTree::build(network, source, isDriving));
+    std::lock_guard<std::mutex> lock(guard);
+    ++totals.built;
+    auto it = trees.find(key);
+    if (it != trees.end()) return it->second;
+    if (used + tree->bytes() > budget && !makeRoom(tree->bytes(), count)) {
+        ++totals.rejected;
+        return tree;
+    }
+    trees.emplace(key, tree);
+    used += tree->bytes();
+    return tree;
+}
+
+bool PathTreeCache::makeRoom(size_t bytes, uint32_t count) {
+    if (bytes > budget) return false;
+    auto requests = [&](uint64_t key) {
+        auto it = frequency.find(key);
+        return it == frequency.end() ? 0u : it->second;
+    };
+    // Least requested first; stop at the first tree requested as often as the newcomer
+    std::vector<std::pair<uint32_t, uint64_t>> candidates;
+    for (const auto& [key, tree] : trees) candidates.emplace_back(requests(key), key);
+    std::sort(candidates.begin(), candidates.end());
+    size_t freed = 0, victims = 0;
+    while (used - freed + bytes > budget) {
+        if (victims == candidates.size() || candidates[victims].first >= count) return false;
+        freed += trees[candidates[victims].second]->bytes();
+        ++victims;
+    }
+    for (size_t i = 0; i < victims; ++i) trees.erase(candidates[i].second);
+    used -= freed;
+    totals.evictions += victims;
+    return true;
+}
+
+size_t PathTreeCache::roadChanged(const GraphSnapshot& network, int fromId, int toId, bool isDriving,
+                                  int oldTime, int newTime) {
+    int a = network.indexOf(fromId), b = network.indexOf(toId);
+    if (a < 0 || b < 0 || newTime == oldTime) return 0;
+    std::lock_guard<std::mutex> lock(guard);
+    size_t dropped = 0;
+    for (auto it = trees.begin(); it != trees.end();) {
+        const PathTree& tree = *it->second;
+        if (tree.isDriving != isDriving || !tree.affectedBy(static_cast<uint32_t>(a), static_cast<uint32_t>(b), oldTime, newTime)) {
+            ++it;
+            continue;
+        }
+        used -= tree.bytes();
+        it = trees.erase(it);
+        ++dropped;
+    }
+    totals.invalidated += dropped;
+    return dropped;
+}
+
+void PathTreeCache::clear() {
+    std::lock_guard<std::mutex> lock(guard);
+    trees.clear();
+    used = 0;
+}
+
+PathTreeCache::Counters PathTreeCache::counters() const {
+    std::lock_guard<std::mutex> lock(guard);
+    return totals;
+}
+
+size_t PathTreeCache::treeCount() const {
+    std::lock_guard<std::mutex> lock(guard);
+    return trees.size();
+}
+
+size_t PathTreeCache::bytes() const {
+    std::lock_guard<std::mutex> lock(guard);
+    return used;
+}
+
+void PathTreeCache::writeText(std::ostream& out) const {
+    Counters c = counters();
+    std::ios::fmtflags flags = out.flags();
+    out << "Path tree cache: " << c.requests << " unrestricted searches, " << std::fixed << std::setprecision(1)
+        << (c.requests ? 100.0 * double(c.hits) / double(c.requests) : 0.0) << "% from trees (" << c.hits
+        << " hits), " << c.built << " trees built, " << c.evictions << " evicted, " << c.rejected << " rejected, "
+        << c.invalidated << " invalidated by road updates, "
+        << treeCount() << " trees in " << bytes() << " of " << budget << " bytes" << std::endl;
+    out.flags(flags);
+}
+
+void PathTreeCache::reportMemory(MemoryReport& report) const {
+    std::lock_guard<std::mutex> lock(guard);
+    size_t treeBytes = MemoryReport::hashTableBytes(trees);
+    for (const auto& [key, tree] : trees) treeBytes += tree->bytes();
+    report.add("tree cache", "trees", treeBytes);
+    report.add("tree cache", "request counts", MemoryReport::hashTableBytes(frequency));
+}
+
+std::pair<std::vector<int>, int> TreeCachedEngine::findPath(
+    int sourceId, int destinationId, bool isDriving,
+    const std::unordered_set<int>& blockedNodes,
+    std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) {
+    int source = network.indexOf(sourceId), destination = network.indexOf(destinationId);
+    if (!blockedNodes.empty() || !blockedSegments.empty() || source < 0 || destination < 0) {
+        return engine->findPath(sourceId, destinationId, isDriving, blockedNodes, blockedSegments);
+    }
+    auto tree = trees.acquire(network, static_cast<uint32_t>(source), isDriving);
+    if (!tree) return engine->findPath(sourceId, destinationId, isDriving, blockedNodes, blockedSegments);
+    return tree->route(network, static_cast<uint32_t>(destination), blockedSegments);
+}
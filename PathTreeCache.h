@@ -0,0 +1,207 @@
+/**
+* @file PathTreeCache.h
+ * @brief Memory-budgeted cache of shortest path trees for frequent sources
+ */
+
+#ifndef PATH_TREE_CACHE_H
+#define PATH_TREE_CACHE_H
+
+#include "GraphSnapshot.h"
+#include "SearchEngine.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+class MemoryReport;
+
+/**
+ * @class PackedArray
+ * @brief Fixed-width unsigned integers packed back to back in 64-bit words
+ * @details The width is the fewest bits holding the largest value, so node indexes of
+ * a 200 000 location network take 18 bits instead of 32.
+ */
+class PackedArray {
+public:
+    /**
+     * @brief Replaces the contents with values.
+     * @complexity O(V) where V is the number of values.
+     */
+    void assign(const std::vector<uint32_t>& values);
+
+    uint32_t operator[](size_t i) const {
+        size_t bit = i * width;
+        size_t word = bit >> 6;
+        unsigned offset = bit & 63;
+        uint64_t value = words[word] >> offset;
+        if (offset + width > 64) value |= words[word + 1] << (64 - offset);
+        return static_cast<uint32_t>(value & mask);
+    }
+
+    unsigned bitsPerValue() const { return width; }
+    size_t bytes() const;
+
+private:
+    std::vector<uint64_t> words;
+    unsigned width = 0;
+    uint64_t mask = 0;
+};
+
+/**
+ * @struct PathTree
+ * @brief Unrestricted shortest path tree of one source in one mode
+ * @details Distances are stored plus one, so 0 marks the locations the source cannot
+ * reach; the parent of the source and of unreached locations is the location itself.
+ */
+struct PathTree {
+    uint32_t source = 0;
+    bool isDriving = true;
+    PackedArray distances;
+    PackedArray parents;
+
+    /**
+     * @brief Builds the tree with the same Dijkstra as ArraySearch.
+     * @complexity O((N + M) log N) where N is the number of locations and M is the number of roads.
+     */
+    static PathTree build(const GraphSnapshot& network, uint32_t source, bool isDriving);
+
+    /**
+     * @brief Follows the parents from destination back to the source.
+     * @details Same result and contract as SearchEngine::findPath without avoided
+     * locations or roads: the segments of the path are added to blockedSegments.
+     * @complexity O(L) where L is the number of locations on the path.
+     */
+    std::pair<std::vector<int>, int> route(const GraphSnapshot& network, uint32_t destination,
+                                           std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) const;
+
+    /**
+     * @brief Check if the tree can change when the road between two locations takes a new time.
+     * @details A slower road changes the tree only if it is a tree edge. A faster one changes it
+     * only if it gives one end a path to the other at most as long as its current distance,
+     * as a path of the same length may win the tie.
+     * @complexity O(1).
+     */
+    bool affectedBy(uint32_t a, uint32_t b, int oldTime, int newTime) const;
+
+    size_t bytes() const { return sizeof(PathTree) + distances.bytes() + parents.bytes(); }
+};
+
+/**
+ * @class PathTreeCache
+ * @brief Keeps the shortest path trees of the sources searched most often
+ * @details Every unrestricted search counts one request for its source and mode. A
+ * source is admitted once it has been requested admitAfter times: its tree is built
+ * and kept if it fits the budget, evicting trees of sources requested less often; if
+ * only more frequent sources are cached it is not admitted. The request counts are
+ * halved periodically so the cache follows changes in the workload.
+ *
+ * Trees are shared with the threads using them, so one cache can serve several
+ * engines over the same network. roadChanged() drops the trees a road update affects;
+ * clear() must be called on any other change to the network.
+ */
+class PathTreeCache {
+public:
+    /**
+     * @struct Counters
+     * @brief Outcomes since the cache was created
+     */
+    struct Counters {
+        uint64_t requests = 0;      ///< Unrestricted searches seen
+        uint64_t hits = 0;          ///< Answered from a cached tree
+        uint64_t built = 0;
+        uint64_t evictions = 0;
+        uint64_t rejected = 0;      ///< Trees built but not kept, as more frequent sources filled the budget
+        uint64_t invalidated = 0;   ///< Trees dropped by road updates
+    };
+
+    /**
+     * @param budgetBytes Bytes the trees may take.
+     * @param admitAfter Requests a source needs before its tree is built.
+     */
+    explicit PathTreeCache(size_t budgetBytes, uint32_t admitAfter = 2);
+
+    /**
+     * @brief Counts a request and returns the tree of the source, building it if admitted.
+     * @return The tree, or nullptr if the source is not cached.
+     */
+    std::shared_ptr<const PathTree> acquire(const GraphSnapshot& network, uint32_t source, bool isDriving);
+
+    /**
+     * @brief Drops the trees of one mode that a road's new time can change.
+     * @param network The network the trees were built on, or one with the same location order.
+     * @return The number of trees dropped.
+     * @complexity O(T) where T is the number of trees.
+     */
+    size_t roadChanged(const GraphSnapshot& network, int fromId, int toId, bool isDriving, int oldTime, int newTime);
+
+    /**
+     * @brief Drops every tree, keeping the request counts.
+     */
+    void clear();
+
+    Counters counters() const;
+    size_t treeCount() const;
+    size_t bytes() const;
+
+    /**
+     * @brief Writes the share of searches answered from trees and the other counters on one line.
+     */
+    void writeText(std::ostream& out) const;
+
+    /**
+     * @brief Adds the trees and the request counts to a memory report.
+     */
+    void reportMemory(MemoryReport& report) const;
+
+private:
+    static uint64_t keyOf(uint32_t source, bool isDriving) { return uint64_t(source) << 1 | isDriving; }
+
+    /**
+     * @brief Makes room for bytes by evicting trees requested fewer than frequency times.
+     * @return False, evicting nothing, if the room cannot be made.
+     */
+    bool makeRoom(size_t bytes, uint32_t frequency);
+
+    size_t budget;
+    uint32_t admitAfter;
+    mutable std::mutex guard;
+    std::unordered_map<uint64_t, std::shared_ptr<const PathTree>> trees;
+    std::unordered_map<uint64_t, uint32_t> frequency;   ///< Requests per source and mode, halved periodically
+    uint64_t sinceAging = 0;
+    size_t used = 0;
+    Counters totals;
+};
+
+/**
+ * @class TreeCachedEngine
+ * @brief Forwards to an engine, answering unrestricted searches from a PathTreeCache
+ * @details A search with no avoided locations or roads from a cached source walks the
+ * tree instead of searching. Its path is the one Dijkstra on the snapshot finds, which
+ * A* and the compressed adjacency may break ties against differently, with the same time.
+ * The multimodal planner runs through the base SearchEngine implementation, so the driving
+ * legs from a hub to every parking location come from one tree.
+ */
+class TreeCachedEngine : public SearchEngine {
+public:
+    TreeCachedEngine(std::unique_ptr<SearchEngine> engine, const GraphSnapshot& network, PathTreeCache& trees)
+        : engine(std::move(engine)), network(network), trees(trees) {}
+
+    const char* name() const override { return engine->name(); }
+    std::pair<std::vector<int>, int> findPath(
+        int sourceId, int destinationId, bool isDriving,
+        const std::unordered_set<int>& blockedNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) override;
+    bool hasLocation(int id) const override { return engine->hasLocation(id); }
+    const std::vector<int>& parkingLocations() override { return engine->parkingLocations(); }
+    void reportMemory(MemoryReport& report) const override { engine->reportMemory(report); }
+
+private:
+    std::unique_ptr<SearchEngine> engine;
+    const GraphSnapshot& network;
+    PathTreeCache& trees;
+};
+
+#endif // PATH_TREE_CACHE_H
@@ -0,0 +1,191 @@
+#include "PerfCounters.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfSample PerfSample::operator-(const PerfSample& earlier) const {
+    PerfSample difference;
+    for (int e = 0; e < EVENTS; ++e) difference.values[e] = values[e] - earlier.values[e];
+    return difference;
+}
+
+PerfSample& PerfSample::operator+=(const PerfSample& other) {
+    for (int e = 0; e < EVENTS; ++e) values[e] += other.values[e];
+    return *this;
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+#ifdef __linux__
+namespace {
+
+/**
+ * @brief perf_event_attr of each PerfSample::Event.
+ */
+perf_event_attr eventAttributes(PerfSample::Event event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+        case PerfSample::Cycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PerfSample::Instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PerfSample::CacheMisses: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case PerfSample::BranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return attr;
+}
+
+} // namespace
+#endif
+
+bool PerfCounters::open() {
+#ifdef __linux__
+    int firstError = 0;
+    for (int e = 0; e < PerfSample::EVENTS; ++e) {
+        perf_event_attr attr = eventAttributes(static_cast<PerfSample::Event>(e));
+        attr.disabled = leader < 0 ? 1 : 0;   // The group starts when its leader is enabled
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) {
+            if (!firstError) firstError = errno;
+            continue;
+        }
+        if (leader < 0) leader = fd;
+        fds[e] = fd;
+        slots[e] = opened++;
+    }
+    if (leader < 0) {
+        std::cerr << "Warning: perf_event_open unavailable (" << std::strerror(firstError)
+                  << "), hardware counters disabled" << std::endl;
+        return false;
+    }
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    std::cerr << "Warning: hardware counters need Linux perf_event_open" << std::endl;
+    return false;
+#endif
+}
+
+bool PerfCounters::read(PerfSample& sample) const {
+#ifdef __linux__
+    if (leader < 0) return false;
+    // nr, time enabled, time running, then one value per event of the group
+    uint64_t buffer[3 + PerfSample::EVENTS];
+    ssize_t expected = static_cast<ssize_t>((3 + opened) * sizeof(uint64_t));
+    if (::read(leader, buffer, sizeof(buffer)) < expected) return false;
+    uint64_t enabled = buffer[1], running = buffer[2];
+    for (int e = 0; e < PerfSample::EVENTS; ++e) {
+        uint64_t value = slots[e] >= 0 ? buffer[3 + slots[e]] : 0;
+        // Scale up when the kernel multiplexed the group
+        if (running > 0 && running < enabled) value = static_cast<uint64_t>(double(value) * double(enabled) / double(running));
+        sample.values[e] = value;
+    }
+    return true;
+#else
+    (void)sample;
+    return false;
+#endif
+}
+
+thread_local PerfProfile* PerfProfile::active = nullptr;
+thread_local const char* PerfProfile::activeEngine = nullptr;
+
+PerfProfile::Scope::Scope(PerfProfile* profile, const char* engine)
+    : previousProfile(active), previousEngine(activeEngine) {
+    active = profile && threadCounters() ? profile : nullptr;
+    activeEngine = engine;
+}
+
+PerfProfile::Scope::~Scope() {
+    active = previousProfile;
+    activeEngine = previousEngine;
+}
+
+const PerfCounters* PerfProfile::threadCounters() {
+    // Opened once per thread; a failure is remembered so it is reported once
+    static thread_local std::unique_ptr<PerfCounters> counters;
+    static thread_local bool tried = false;
+    if (!tried) {
+        tried = true;
+        counters = std::make_unique<PerfCounters>();
+        if (!counters->open()) counters.reset();
+    }
+    return counters.get();
+}
+
+void PerfProfile::add(Phase phase, const PerfSample& sample) {
+    std::lock_guard<std::mutex> lock(guard);
+    Totals& entry = totals[activeEngine ? activeEngine : "unknown"][phase];
+    ++entry.calls;
+    entry.events += sample;
+}
+
+void PerfProfile::writeText(std::ostream& out) const {
+    static const char* const PHASE_NAMES[] = {"init", "search", "path", "output"};
+    // Events the reporting thread cannot count were not counted by the others either
+    const PerfCounters* counters = threadCounters();
+    std::lock_guard<std::mutex> lock(guard);
+    std::ios::fmtflags flags = out.flags();
+    out << std::left << std::setw(12) << "engine" << std::setw(8) << "phase" << std::right << std::setw(10) << "calls"
+        << std::setw(14) << "cycles/call" << std::setw(14) << "instr/call" << std::setw(7) << "IPC"
+        << std::setw(13) << "cache MPKI" << std::setw(14) << "branch MPKI" << std::setw(12) << "dTLB MPKI" << '\n';
+    out << std::fixed;
+    for (const auto& [engine, phases] : totals) {
+        for (int p = 0; p < PHASES; ++p) {
+            const Totals& t = phases[p];
+            if (t.calls == 0) continue;
+            const auto& v = t.events.values;
+            double instructions = double(std::max<uint64_t>(v[PerfSample::Instructions], 1));
+            auto perKilo = [&](PerfSample::Event e, int width) -> std::ostream& {
+                if (counters && !counters->counts(e)) return out << std::setw(width) << "n/a";
+                return out << std::setw(width) << 1000.0 * double(v[e]) / instructions;
+            };
+            out << std::left << std::setw(12) << engine << std::setw(8) << PHASE_NAMES[p] << std::right
+                << std::setw(10) << t.calls << std::setprecision(0)
+                << std::setw(14) << double(v[PerfSample::Cycles]) / double(t.calls)
+                << std::setw(14) << double(v[PerfSample::Instructions]) / double(t.calls) << std::setprecision(2)
+                << std::setw(7) << double(v[PerfSample::Instructions]) / double(std::max<uint64_t>(v[PerfSample::Cycles], 1));
+            perKilo(PerfSample::CacheMisses, 13);
+            perKilo(PerfSample::BranchMisses, 14);
+            perKilo(PerfSample::DtlbMisses, 12) << '\n';
+        }
+    }
+    out.flags(flags);
+}
+
+void PerfPhase::start(PerfProfile::Phase next) {
+    counters = PerfProfile::threadCounters();
+    phase = next;
+    if (counters && !counters->read(begin)) counters = nullptr;
+}
+
+void PerfPhase::stop() {
+    PerfSample end;
+    PerfProfile* profile = PerfProfile::current();
+    if (profile && counters->read(end)) profile->add(phase, end - begin);
+}
@@ -0,0 +1,173 @@
+/**
+* @file PerfCounters.h
+ * @brief Hardware performance counters around the search phases (Linux perf_event_open)
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+/**
+ * @struct PerfSample
+ * @brief Values of the hardware events, scaled for multiplexing
+ */
+struct PerfSample {
+    enum Event { Cycles, Instructions, CacheMisses, BranchMisses, DtlbMisses, EVENTS };
+
+    std::array<uint64_t, EVENTS> values{};
+
+    PerfSample operator-(const PerfSample& earlier) const;
+    PerfSample& operator+=(const PerfSample& other);
+};
+
+/**
+ * @class PerfCounters
+ * @brief The hardware events of the calling thread, opened as one perf_event group
+ * @details Events the CPU or kernel does not provide are left out and read as zero.
+ * Opening fails where perf_event_open is unavailable (other systems, containers or a
+ * restrictive perf_event_paranoid setting).
+ */
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * @brief Opens and starts the counters for the calling thread.
+     * @return False if no event could be opened; the reason is printed on cerr.
+     */
+    bool open();
+
+    /**
+     * @brief Reads the current counts.
+     * @return False if the counters are not open or could not be read.
+     */
+    bool read(PerfSample& sample) const;
+
+    /**
+     * @brief Check if the given event is counted.
+     */
+    bool counts(PerfSample::Event event) const { return slots[event] >= 0; }
+
+private:
+    int leader = -1;                            ///< Group leader file descriptor
+    std::array<int, PerfSample::EVENTS> fds{-1, -1, -1, -1, -1};
+    std::array<int, PerfSample::EVENTS> slots{-1, -1, -1, -1, -1};   ///< Position of each event in a group read
+    int opened = 0;                             ///< Number of events in the group
+};
+
+/**
+ * @class PerfProfile
+ * @brief Hardware event totals per engine and search phase
+ * @details While a Scope is alive on a thread, the PerfPhase sections run on that
+ * thread read the thread's counters and add the difference to the scope's engine.
+ * Without a Scope, PerfPhase costs one thread-local check.
+ */
+class PerfProfile {
+public:
+    enum Phase { Initialisation, Search, PathReconstruction, Output, PHASES };
+
+    /**
+     * @class Scope
+     * @brief Attributes the phases run on this thread to an engine
+     */
+    class Scope {
+    public:
+        /**
+         * @param profile Profile to add to, or nullptr to disable profiling for the scope.
+         */
+        Scope(PerfProfile* profile, const char* engine);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PerfProfile* previousProfile;
+        const char* previousEngine;
+    };
+
+    /**
+     * @brief Profile active on the calling thread, if any.
+     */
+    static PerfProfile* current() { return active; }
+
+    /**
+     * @brief Counters of the calling thread, opened on first use.
+     * @return nullptr if they cannot be opened.
+     */
+    static const PerfCounters* threadCounters();
+
+    /**
+     * @brief Adds one run of a phase for the engine of the current scope.
+     */
+    void add(Phase phase, const PerfSample& sample);
+
+    /**
+     * @brief Writes the totals: calls, per-call averages, IPC and misses per thousand instructions.
+     */
+    void writeText(std::ostream& out) const;
+
+private:
+    /**
+     * @struct Totals
+     * @brief Accumulated events of one engine and phase
+     */
+    struct Totals {
+        uint64_t calls = 0;
+        PerfSample events;
+    };
+
+    static thread_local PerfProfile* active;
+    static thread_local const char* activeEngine;
+
+    mutable std::mutex guard;                                   ///< Guards totals
+    std::map<std::string, std::array<Totals, PHASES>> totals;   ///< Per engine name
+};
+
+/**
+ * @class PerfPhase
+ * @brief Measures consecutive phases of a search with the thread's counters
+ * @details Does nothing unless a PerfProfile::Scope is active on the thread.
+ */
+class PerfPhase {
+public:
+    explicit PerfPhase(PerfProfile::Phase phase) {
+        if (PerfProfile::current()) start(phase);
+    }
+
+    /**
+     * @brief Ends the current phase and starts the next one.
+     */
+    void next(PerfProfile::Phase phase) {
+        if (!counters) return;
+        stop();
+        start(phase);
+    }
+
+    ~PerfPhase() {
+        if (counters) stop();
+    }
+
+    PerfPhase(const PerfPhase&) = delete;
+    PerfPhase& operator=(const PerfPhase&) = delete;
+
+private:
+    void start(PerfProfile::Phase phase);
+    void stop();
+
+    const PerfCounters* counters = nullptr;
+    PerfProfile::Phase phase = PerfProfile::Initialisation;
+    PerfSample begin;
+};
+
+#endif // PERF_COUNTERS_H
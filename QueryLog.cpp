@@ -0,0 +1,236 @@
+#include "QueryLog.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+void appendVarint(std::string& buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+void appendSigned(std::string& buffer, int64_t value) {
+    appendVarint(buffer, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+} // namespace
+
+QueryCapture::~QueryCapture() {
+    if (active()) stop();
+}
+
+bool QueryCapture::start(const std::string& name, size_t capacity) {
+    if (active()) stop();
+    file = std::fopen(name.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Unable to open " << name << std::endl;
+        return false;
+    }
+    QueryLogHeader header{};
+    std::memcpy(header.magic, QueryLogHeader::MAGIC, sizeof(header.magic));
+    header.version = QueryLogHeader::VERSION;
+    failed = std::fwrite(&header, sizeof(header), 1, file) != 1;
+
+    size_t size = 4096;
+    while (size < capacity) size <<= 1;
+    ring.assign(size, 0);
+    mask = size - 1;
+    head = tail = 0;
+    stopping = false;
+    filename = name;
+    startTime = std::chrono::steady_clock::now();
+    lastMicros = recorded = dropped = 0;
+    writer = std::thread(&QueryCapture::run, this);
+    return true;
+}
+
+void QueryCapture::record(const Input& input) {
+    if (!active()) return;
+    uint64_t micros = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count());
+
+    scratch.clear();
+    scratch.push_back(static_cast<char>(input.TypeOfInput));
+    appendVarint(scratch, micros - lastMicros);
+    appendSigned(scratch, input.sourceId);
+    appendSigned(scratch, input.destId);
+    appendSigned(scratch, input.maxWalkingTime);
+    appendSigned(scratch, input.includeNodeId);
+    sortedNodes.assign(input.avoidNodes.begin(), input.avoidNodes.end());
+    std::sort(sortedNodes.begin(), sortedNodes.end());
+    appendVarint(scratch, sortedNodes.size());
+    int64_t previous = 0;
+    for (int id : sortedNodes) {
+        appendSigned(scratch, id - previous);
+        previous = id;
+    }
+    sortedSegments.assign(input.avoidSegments.begin(), input.avoidSegments.end());
+    std::sort(sortedSegments.begin(), sortedSegments.end());
+    appendVarint(scratch, sortedSegments.size());
+    previous = 0;
+    for (const auto& [from, to] : sortedSegments) {
+        appendSigned(scratch, from - previous);
+        appendSigned(scratch, int64_t(to) - from);
+        previous = from;
+    }
+
+    char prefix[10];
+    size_t length = 0;
+    for (uint64_t value = scratch.size(); ; value >>= 7) {
+        prefix[length++] = static_cast<char>(value >= 0x80 ? (value & 0x7f) | 0x80 : value);
+        if (value < 0x80) break;
+    }
+    size_t bytes = length + scratch.size();
+    uint64_t position = head.load(std::memory_order_relaxed);
+    if (bytes > ring.size() - (position - tail.load(std::memory_order_acquire))) {
+        ++dropped;
+        return;
+    }
+    auto copy = [&](const char* data, size_t size) {
+        size_t offset = position & mask;
+        size_t first = std::min(size, ring.size() - offset);
+        std::memcpy(ring.data() + offset, data, first);
+        std::memcpy(ring.data(), data + first, size - first);
+        position += size;
+    };
+    copy(prefix, length);
+    copy(scratch.data(), scratch.size());
+    head.store(position, std::memory_order_release);
+    lastMicros = micros;
+    ++recorded;
+}
+
+bool QueryCapture::drain() {
+    uint64_t begin = tail.load(std::memory_order_relaxed);
+    uint64_t end = head.load(std::memory_order_acquire);
+    if (begin == end) return false;
+    size_t offset = begin & mask;
+    size_t first = std::min<size_t>(end - begin, ring.size() - offset);
+    if (std::fwrite(ring.data() + offset, 1, first, file) != first) failed = true;
+    size_t rest = static_cast<size_t>(end - begin) - first;
+    if (rest > 0 && std::fwrite(ring.data(), 1, rest, file) != rest) failed = true;
+    tail.store(end, std::memory_order_release);
+    return true;
+}
+
+void QueryCapture::run() {
+    while (true) {
+        bool finishing = stopping.load(std::memory_order_acquire);
+        if (drain()) continue;
+        if (finishing) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+bool QueryCapture::stop() {
+    if (!active()) return true;
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+    if (std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    std::cerr << "Query log: " << recorded << " queries written to " << filename;
+    if (dropped > 0) std::cerr << ", " << dropped << " dropped with the buffer full";
+    std::cerr << std::endl;
+    if (failed) std::cerr << "Error: Unable to write " << filename << std::endl;
+    return !failed;
+}
+
+bool QueryLogReader::open(const std::string& filename) {
+    corrupt = false;
+    position = end = nullptr;
+    micros = 0;
+    if (!file.open(filename)) {
+        std::cerr << "Error: Unable to open " << filename << std::endl;
+        return false;
+    }
+    file.advise(MappedFile::Access::Sequential);
+    std::string_view bytes = file.view();
+    QueryLogHeader header;
+    if (bytes.size() < sizeof(header)) {
+        std::cerr << "Error: " << filename << " is not a query log" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, QueryLogHeader::MAGIC, sizeof(header.magic)) != 0
+        || header.version != QueryLogHeader::VERSION) {
+        std::cerr << "Error: " << filename << " is not a query log" << std::endl;
+        return false;
+    }
+    position = bytes.data() + sizeof(header);
+    end = bytes.data() + bytes.size();
+    return true;
+}
+
+bool QueryLogReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && position < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*position++);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool QueryLogReader::readSigned(int& value) {
+    uint64_t code;
+    if (!readVarint(code)) return false;
+    value = static_cast<int>(static_cast<int64_t>(code >> 1) ^ -static_cast<int64_t>(code & 1));
+    return true;
+}
+
+bool QueryLogReader::decode(LoggedQuery& query) {
+    Input& input = query.input;
+    if (position == end) return false;
+    input.TypeOfInput = static_cast<int8_t>(*position++);
+    uint64_t delta, count;
+    if (!readVarint(delta) || !readSigned(input.sourceId) || !readSigned(input.destId)
+        || !readSigned(input.maxWalkingTime) || !readSigned(input.includeNodeId)) {
+        return false;
+    }
+    micros += delta;
+    query.micros = micros;
+
+    input.avoidNodes.clear();
+    // Every item takes at least one byte, which bounds the reservation for corrupt counts
+    if (!readVarint(count) || count > uint64_t(end - position)) return false;
+    input.avoidNodes.reserve(count);
+    int id = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        int difference;
+        if (!readSigned(difference)) return false;
+        id += difference;
+        input.avoidNodes.insert(id);
+    }
+
+    input.avoidSegments.clear();
+    if (!readVarint(count) || count > uint64_t(end - position)) return false;
+    input.avoidSegments.reserve(count);
+    int from = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        int fromDifference, toDifference;
+        if (!readSigned(fromDifference) || !readSigned(toDifference)) return false;
+        from += fromDifference;
+        input.avoidSegments.insert({from, from + toDifference});
+    }
+    return true;
+}
+
+bool QueryLogReader::next(LoggedQuery& query) {
+    if (corrupt || position == end) return false;
+    uint64_t size;
+    if (!readVarint(size) || size > uint64_t(end - position)) {
+        corrupt = true;
+        return false;
+    }
+    const char* logEnd = end;
+    const char* recordEnd = position + size;
+    end = recordEnd;
+    corrupt = !decode(query) || position != recordEnd;
+    position = recordEnd;
+    end = logEnd;
+    return !corrupt;
+}
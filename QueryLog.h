@@ -0,0 +1,149 @@
+/**
+* @file QueryLog.h
+ * @brief Compact binary log of the queries answered, for capture and replay
+ */
+
+#ifndef QUERY_LOG_H
+#define QUERY_LOG_H
+
+#include "FileManager.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct QueryLogHeader
+ * @brief Fixed header at the start of a query log
+ * @details It is followed by one record per query: the record's payload size as a varint,
+ * then the mode byte, the microseconds since the previous query (since the start of the
+ * capture for the first one), source, destination, maximum walking time and include node.
+ * Then come the avoided locations, as their count followed by the sorted IDs as
+ * differences, and the avoided segments, as their count followed by each sorted pair: its
+ * origin as a difference from the previous origin and its destination as a difference
+ * from its origin. Signed values are zigzag varints, as in the binary result stream.
+ */
+struct QueryLogHeader {
+    static constexpr char MAGIC[8] = {'R', 'T', 'Q', 'U', 'E', 'R', 'Y', 'S'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];       ///< MAGIC
+    uint32_t version;    ///< VERSION
+    uint32_t reserved;   ///< Zero
+};
+
+/**
+ * @struct LoggedQuery
+ * @brief One query read back from a log
+ */
+struct LoggedQuery {
+    uint64_t micros = 0;   ///< Time since the start of the capture
+    Input input;
+};
+
+/**
+ * @class QueryCapture
+ * @brief Records the incoming queries to a query log without blocking on the disk
+ * @details record() encodes the query into a lock-free single-producer ring buffer that
+ * a background thread drains to the file. It must always be called from the same thread,
+ * the one answering queries. When the writer falls behind and the ring is full the query
+ * is dropped rather than delaying the caller; drops are counted and reported by stop().
+ */
+class QueryCapture {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 22;   ///< Ring buffer bytes
+
+    QueryCapture() = default;
+    ~QueryCapture();
+
+    QueryCapture(const QueryCapture&) = delete;
+    QueryCapture& operator=(const QueryCapture&) = delete;
+
+    /**
+     * @brief Creates the log file and starts the writer thread.
+     * @param capacity Ring buffer size, rounded up to a power of two.
+     * @return True on success; errors are reported on cerr.
+     */
+    bool start(const std::string& filename, size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Check if a capture is running.
+     */
+    bool active() const { return file != nullptr; }
+
+    /**
+     * @brief Records a query as received, before the planners extend its avoided segments.
+     * @complexity O(A log A) where A is the number of avoided items.
+     */
+    void record(const Input& input);
+
+    /**
+     * @brief Writes the remaining records, closes the log and reports the counts on cerr.
+     * @return False if any write failed.
+     */
+    bool stop();
+
+private:
+    void run();
+    bool drain();
+
+    std::vector<char> ring;                  ///< Encoded records not yet written
+    size_t mask = 0;                         ///< ring.size() - 1
+    std::atomic<uint64_t> head{0};           ///< Bytes ever produced, advanced by record()
+    std::atomic<uint64_t> tail{0};           ///< Bytes ever written, advanced by the writer
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+    std::FILE* file = nullptr;
+    std::string filename;
+    bool failed = false;                     ///< A write failed; only touched by the writer
+
+    std::string scratch;                     ///< Encoding buffer of the producer
+    std::vector<int> sortedNodes;
+    std::vector<std::pair<int, int>> sortedSegments;
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t lastMicros = 0;
+    uint64_t recorded = 0;
+    uint64_t dropped = 0;
+};
+
+/**
+ * @class QueryLogReader
+ * @brief Decodes the records of a query log
+ */
+class QueryLogReader {
+public:
+    /**
+     * @brief Maps a query log and checks its header.
+     * @return True if the file is a query log of a supported version.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Decodes the next query.
+     * @return False at the end of the log or on a corrupt record (see failed()).
+     */
+    bool next(LoggedQuery& query);
+
+    /**
+     * @brief Check if decoding stopped on a corrupt or truncated record.
+     */
+    bool failed() const { return corrupt; }
+
+private:
+    bool readVarint(uint64_t& value);
+    bool readSigned(int& value);
+    bool decode(LoggedQuery& query);
+
+    MappedFile file;
+    const char* position = nullptr;   ///< Next byte to decode
+    const char* end = nullptr;        ///< End of the log, or of the current record while decoding
+    uint64_t micros = 0;              ///< Time of the last decoded query
+    bool corrupt = false;
+};
+
+#endif // QUERY_LOG_H
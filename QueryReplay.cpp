@@ -0,0 +1,165 @@
+#include "QueryReplay.h"
+#include "AllPairsTable.h"
+#include "CompressedGraph.h"
+#include "GraphSnapshot.h"
+#include "LandmarkIndex.h"
+#include "PathTreeCache.h"
+#include "QueryLog.h"
+#include "RouteCache.h"
+#include "RoutePlanner.h"
+#include "SearchEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+using namespace std;
+
+namespace {
+
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[min(sorted.size() - 1, static_cast<size_t>(p * double(sorted.size())))];
+}
+
+/**
+ * @struct ReplayResult
+ * @brief Latencies of one engine over the whole log
+ */
+struct ReplayResult {
+    vector<double> milliseconds;   ///< Merged from every thread
+    double seconds = 0;
+    size_t failed = 0;
+};
+
+/**
+ * @brief Answers every query with one engine per thread.
+ */
+ReplayResult replay(const vector<LoggedQuery>& queries, vector<unique_ptr<SearchEngine>>& engines, bool recordedSpeed,
+                    RouteCache* cache) {
+    using Clock = chrono::steady_clock;
+    vector<vector<double>> latencies(engines.size());
+    atomic<size_t> nextQuery{0};
+    atomic<size_t> failed{0};
+    uint64_t firstMicros = queries.empty() ? 0 : queries.front().micros;
+    Clock::time_point start = Clock::now();
+    auto work = [&](size_t t) {
+        SearchEngine& engine = *engines[t];
+        for (size_t i = nextQuery++; i < queries.size(); i = nextQuery++) {
+            Clock::time_point issued = Clock::now();
+            if (recordedSpeed) {
+                issued = start + chrono::microseconds(queries[i].micros - firstMicros);
+                this_thread::sleep_until(issued);
+            }
+            Input input = queries[i].input; // The planners extend the avoided segments
+            Output output;
+            uint64_t key = cache ? RouteCache::fingerprint(input) : 0;
+            bool answered = cache && cache->lookup(key, output);
+            if (!answered) {
+                answered = RoutePlanner::solve(engine, input, output);
+                if (answered && cache) cache->insert(key, output);
+            }
+            answered = answered && !output.bestPath.first.empty();
+            latencies[t].push_back(chrono::duration<double, milli>(Clock::now() - issued).count());
+            if (!answered) ++failed;
+        }
+    };
+    vector<thread> workers;
+    for (size_t t = 1; t < engines.size(); ++t) workers.emplace_back(work, t);
+    work(0);
+    for (auto& worker : workers) worker.join();
+
+    ReplayResult result;
+    result.seconds = chrono::duration<double>(Clock::now() - start).count();
+    result.failed = failed;
+    for (const auto& thread : latencies) result.milliseconds.insert(result.milliseconds.end(), thread.begin(), thread.end());
+    return result;
+}
+
+} // namespace
+
+bool QueryReplay::run(const ReplayOptions& options, ostream& out) {
+    vector<LoggedQuery> queries;
+    QueryLogReader reader;
+    if (!reader.open(options.logFile)) return false;
+    for (LoggedQuery query; reader.next(query);) queries.push_back(query);
+    if (reader.failed()) {
+        cerr << "Error: " << options.logFile << " has a corrupt record after query " << queries.size() << endl;
+        return false;
+    }
+
+    bool needsGraph = find(options.engines.begin(), options.engines.end(), "reference") != options.engines.end();
+    Graph graph;
+    GraphSnapshot snapshot;
+    if (!options.snapshotFile.empty()) {
+        if (!snapshot.open(options.snapshotFile)) return false;
+        if (needsGraph) snapshot.toGraph(&graph);
+    } else {
+        FileManager::loadLocations(options.locationsFile, &graph);
+        FileManager::loadDistances(options.distancesFile, &graph);
+        if (graph.getLocations().empty()) return false;
+        snapshot = GraphSnapshot::fromGraph(graph);
+    }
+    out << "Replay: " << queries.size() << " queries from " << options.logFile << ", "
+        << snapshot.nodeCount() << " locations, "
+        << (options.recordedSpeed ? "recorded speed" : "maximum speed") << endl;
+
+    LandmarkIndex landmarks;
+    CompressedGraph compressed;
+    AllPairsTable allPairs;
+    out << left << setw(12) << "engine" << right << setw(9) << "threads" << setw(9) << "queries" << setw(8) << "failed"
+        << setw(12) << "qps" << setw(12) << "p50 (ms)" << setw(12) << "p99 (ms)" << setw(12) << "max (ms)" << endl;
+    out << fixed;
+    for (const string& name : options.engines) {
+        if (name == "alt" && landmarks.landmarkCount() == 0) landmarks = LandmarkIndex::build(snapshot, options.landmarks);
+        if (name == "compressed" && compressed.nodeCount() == 0) compressed = CompressedGraph::build(snapshot);
+        if (name == "all-pairs" && allPairs.nodeCount() == 0) {
+            uint32_t limit = min(options.allPairsLimit, AllPairsTable::MAX_NODES);
+            if (snapshot.nodeCount() > limit) {
+                cerr << "Error: network of " << snapshot.nodeCount() << " locations exceeds the all-pairs limit of "
+                     << limit << endl;
+                return false;
+            }
+            allPairs = AllPairsTable::build(snapshot);
+        }
+        unsigned threads = name == "reference" ? 1 : max(1u, options.threads);
+        vector<unique_ptr<SearchEngine>> engines;
+        for (unsigned t = 0; t < threads; ++t) {
+            if (name == "reference") engines.push_back(make_unique<ReferenceEngine>(graph));
+            else if (name == "snapshot") engines.push_back(make_unique<SnapshotEngine>(snapshot));
+            else if (name == "alt") engines.push_back(make_unique<SnapshotEngine>(snapshot, &landmarks));
+            else if (name == "compressed") engines.push_back(make_unique<CompressedEngine>(compressed));
+            else if (name == "all-pairs") {
+                engines.push_back(make_unique<AllPairsEngine>(make_unique<SnapshotEngine>(snapshot), snapshot, allPairs));
+            } else {
+                cerr << "Error: Unknown engine " << name << endl;
+                return false;
+            }
+        }
+        unique_ptr<PathTreeCache> trees;
+        if (options.treeCacheBytes > 0) {
+            trees = make_unique<PathTreeCache>(options.treeCacheBytes);
+            for (auto& engine : engines) engine = make_unique<TreeCachedEngine>(std::move(engine), snapshot, *trees);
+        }
+
+        // The planners report unanswerable queries on cerr; keep the report readable
+        streambuf* errors = cerr.rdbuf(nullptr);
+        unique_ptr<RouteCache> cache;
+        if (options.cacheEntries > 0) cache = make_unique<RouteCache>(options.cacheEntries);
+        ReplayResult result = replay(queries, engines, options.recordedSpeed, cache.get());
+        cerr.clear();
+        cerr.rdbuf(errors);
+
+        vector<double>& sorted = result.milliseconds;
+        sort(sorted.begin(), sorted.end());
+        out << left << setw(12) << name << right << setw(9) << threads << setw(9) << queries.size()
+            << setw(8) << result.failed << setw(12) << setprecision(1) << double(queries.size()) / max(result.seconds, 1e-9)
+            << setw(12) << setprecision(3) << percentile(sorted, 0.50) << setw(12) << percentile(sorted, 0.99)
+            << setw(12) << (sorted.empty() ? 0 : sorted.back()) << endl;
+        if (cache) cache->writeText(out);
+        if (trees) trees->writeText(out);
+    }
+    return true;
+}
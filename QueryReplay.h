@@ -0,0 +1,56 @@
+/**
+* @file QueryReplay.h
+ * @brief Benchmark replaying a captured query log on every engine
+ */
+
+#ifndef QUERY_REPLAY_H
+#define QUERY_REPLAY_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @struct ReplayOptions
+ * @brief Settings of a replay run
+ */
+struct ReplayOptions {
+    std::string logFile;                            ///< Query log written with --capture
+    std::string snapshotFile;                       ///< Network as a snapshot; the CSV files otherwise
+    std::string locationsFile = "LocSample.txt";
+    std::string distancesFile = "DisSample.txt";
+    std::vector<std::string> engines = {"reference", "snapshot", "alt", "compressed"};
+    uint32_t landmarks = 16;
+    uint32_t allPairsLimit = 2048;                  ///< Largest network the all-pairs engine builds tables for
+    unsigned threads = 1;                           ///< Threads answering the queries of each engine
+    bool recordedSpeed = false;                     ///< Issue the queries at their captured times
+    size_t cacheEntries = 0;                        ///< Size of a route cache shared by the threads, 0 for none
+    size_t treeCacheBytes = 0;                      ///< Budget of a path tree cache shared by the threads, 0 for none
+};
+
+/**
+ * @class QueryReplay
+ * @brief Answers the queries of a log with each engine and reports latency and throughput
+ * @details The queries are taken in log order by a pool of threads, each with its own
+ * engine instance over the shared network and indexes. The reference engine keeps its
+ * search state in the Graph, so it is always replayed on one thread.
+ *
+ * At maximum speed every thread takes the next query as soon as it is done. At recorded
+ * speed each query is issued when its captured time is reached, and its latency counts
+ * from then rather than from when a thread took it, so a backlog of queries shows in the
+ * latencies as it would for the clients.
+ *
+ * With a route cache or a path tree cache, each engine starts with empty caches shared
+ * by its threads, and their hit rates are reported after its line.
+ */
+class QueryReplay {
+public:
+    /**
+     * @brief Replays the log and writes one line per engine on out.
+     * @return False if the log or the network could not be read.
+     */
+    static bool run(const ReplayOptions& options, std::ostream& out);
+};
+
+#endif // QUERY_REPLAY_H
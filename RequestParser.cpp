@@ -0,0 +1,289 @@
+#include "RequestParser.h"
+#include <charconv>
+
+namespace {
+
+/**
+ * @class Cursor
+ * @brief Position in the request line, with the token readers of the grammar
+ */
+class Cursor {
+public:
+    explicit Cursor(std::string_view text) : position(text.data()), end(text.data() + text.size()) {}
+
+    void skipSpace() {
+        while (position < end && (*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n')) ++position;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return position == end;
+    }
+
+    /**
+     * @brief Consumes the given character after optional whitespace.
+     */
+    bool consume(char c) {
+        skipSpace();
+        if (position == end || *position != c) return false;
+        ++position;
+        return true;
+    }
+
+    /**
+     * @brief Reads a string and returns its raw contents, escapes left in place.
+     */
+    bool readString(std::string_view& value) {
+        if (!consume('"')) return false;
+        const char* start = position;
+        while (position < end && *position != '"') {
+            if (*position == '\\' && ++position == end) return false;
+            ++position;
+        }
+        if (position == end) return false;
+        value = std::string_view(start, position - start);
+        ++position;
+        return true;
+    }
+
+    bool readInt(int& value) {
+        skipSpace();
+        auto [next, ec] = std::from_chars(position, end, value);
+        if (ec != std::errc()) return false;
+        position = next;
+        return true;
+    }
+
+    /**
+     * @brief Skips any JSON value and returns its raw text.
+     */
+    bool skipValue(std::string_view& raw) {
+        skipSpace();
+        const char* start = position;
+        if (position == end) return false;
+        std::string_view ignored;
+        if (*position == '"') {
+            if (!readString(ignored)) return false;
+        } else if (*position == '{' || *position == '[') {
+            // Brackets are matched by depth only; strings are skipped so their brackets do not count
+            int depth = 0;
+            do {
+                if (*position == '"') {
+                    if (!readString(ignored)) return false;
+                    continue;
+                }
+                if (*position == '{' || *position == '[') ++depth;
+                else if (*position == '}' || *position == ']') --depth;
+                ++position;
+            } while (depth > 0 && position < end);
+            if (depth > 0) return false;
+        } else {
+            while (position < end && *position != ',' && *position != '}' && *position != ']'
+                   && *position != ' ' && *position != '\t') {
+                ++position;
+            }
+            if (position == start) return false;
+        }
+        raw = std::string_view(start, position - start);
+        return true;
+    }
+
+    /**
+     * @brief Reads a JSON string, number, true, false or null and returns its raw text.
+     * @details The text is echoed verbatim in responses, so it is checked against the JSON
+     * grammar; strings may not hold control characters.
+     */
+    bool readScalar(std::string_view& raw) {
+        skipSpace();
+        const char* start = position;
+        if (position < end && *position == '"') {
+            std::string_view contents;
+            if (!readString(contents)) return false;
+            for (size_t i = 0; i < contents.size(); ++i) {
+                if (static_cast<unsigned char>(contents[i]) < 0x20) return false;
+            }
+        } else if (!readLiteral("true") && !readLiteral("false") && !readLiteral("null") && !readNumber()) {
+            return false;
+        }
+        raw = std::string_view(start, position - start);
+        return true;
+    }
+
+    /**
+     * @brief Reads an array, calling readItem for each element.
+     */
+    template <typename ItemReader>
+    bool readArray(ItemReader readItem) {
+        if (!consume('[')) return false;
+        if (consume(']')) return true;
+        do {
+            if (!readItem()) return false;
+        } while (consume(','));
+        return consume(']');
+    }
+
+private:
+    bool readLiteral(std::string_view literal) {
+        if (size_t(end - position) < literal.size() || std::string_view(position, literal.size()) != literal) return false;
+        position += literal.size();
+        return true;
+    }
+
+    bool readDigits() {
+        const char* start = position;
+        while (position < end && *position >= '0' && *position <= '9') ++position;
+        return position > start;
+    }
+
+    /**
+     * @brief Reads a number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+     */
+    bool readNumber() {
+        const char* start = position;
+        if (position < end && *position == '-') ++position;
+        if (position < end && *position == '0') ++position;
+        else if (!readDigits()) return (position = start, false);
+        if (position < end && *position == '.' && (++position, !readDigits())) return (position = start, false);
+        if (position < end && (*position == 'e' || *position == 'E')) {
+            ++position;
+            if (position < end && (*position == '+' || *position == '-')) ++position;
+            if (!readDigits()) return (position = start, false);
+        }
+        return true;
+    }
+
+    const char* position;
+    const char* end;
+};
+
+} // namespace
+
+bool RequestParser::parse(std::string_view line, Input& input, std::string_view& id, const char*& error,
+                          RoadUpdate* update, SubscriptionRequest* subscription) {
+    input.sourceId = -1;
+    input.destId = -1;
+    input.maxWalkingTime = -1;
+    input.includeNodeId = -1;
+    input.TypeOfInput = -1;
+    input.avoidNodes.clear();
+    input.avoidSegments.clear();
+    id = {};
+    RoadUpdate times;
+    SubscriptionRequest standing;
+
+    Cursor cursor(line);
+    if (!cursor.consume('{')) {
+        error = "expected a JSON object";
+        return false;
+    }
+    if (!cursor.consume('}')) {
+        do {
+            std::string_view key;
+            if (!cursor.readString(key) || !cursor.consume(':')) {
+                error = "expected a key";
+                return false;
+            }
+            bool valid = true;
+            if (key == "id") {
+                if (!cursor.readScalar(id)) {
+                    error = "id must be a string, number, true, false or null";
+                    return false;
+                }
+            } else if (key == "mode") {
+                std::string_view mode;
+                valid = cursor.readString(mode);
+                if (mode == "driving") input.TypeOfInput = 0;
+                else if (mode == "restricted") input.TypeOfInput = 1;
+                else if (mode == "driving-walking") input.TypeOfInput = 2;
+                else if (mode == "update-road" && update) input.TypeOfInput = ROAD_UPDATE;
+                else if (mode == "unsubscribe" && subscription) input.TypeOfInput = UNSUBSCRIBE;
+                else valid = false;
+            } else if (key == "source") {
+                valid = cursor.readInt(input.sourceId);
+            } else if (key == "destination") {
+                valid = cursor.readInt(input.destId);
+            } else if (key == "maxWalkingTime") {
+                valid = cursor.readInt(input.maxWalkingTime);
+            } else if (key == "includeNode") {
+                valid = cursor.readInt(input.includeNodeId);
+            } else if (key == "drivingTime") {
+                std::string_view raw;
+                if (cursor.readInt(times.drivingTime)) valid = times.drivingTime >= 0;
+                else if (cursor.skipValue(raw) && raw == "null") times.drivingTime = INF;
+                else valid = false;
+            } else if (key == "walkingTime") {
+                std::string_view raw;
+                if (cursor.readInt(times.walkingTime)) valid = times.walkingTime >= 0;
+                else if (cursor.skipValue(raw) && raw == "null") times.walkingTime = INF;
+                else valid = false;
+            } else if (key == "subscribe" && subscription) {
+                std::string_view raw;
+                valid = cursor.skipValue(raw) && (raw == "true" || raw == "false");
+                standing.subscribe = raw == "true";
+            } else if (key == "subscription" && subscription) {
+                int number;
+                valid = cursor.readInt(number) && number >= 0;
+                standing.subscription = number;
+            } else if (key == "avoidNodes") {
+                valid = cursor.readArray([&] {
+                    int node;
+                    if (!cursor.readInt(node)) return false;
+                    input.avoidNodes.insert(node);
+                    return true;
+                });
+            } else if (key == "avoidSegments") {
+                valid = cursor.readArray([&] {
+                    int from, to;
+                    if (!cursor.consume('[') || !cursor.readInt(from) || !cursor.consume(',')
+                        || !cursor.readInt(to) || !cursor.consume(']')) {
+                        return false;
+                    }
+                    input.avoidSegments.insert({from, to});
+                    return true;
+                });
+            } else {
+                std::string_view ignored;
+                valid = cursor.skipValue(ignored);
+            }
+            if (!valid) {
+                error = "invalid value";
+                return false;
+            }
+        } while (cursor.consume(','));
+        if (!cursor.consume('}')) {
+            error = "expected ',' or '}'";
+            return false;
+        }
+    }
+    if (!cursor.atEnd()) {
+        error = "unexpected text after the object";
+        return false;
+    }
+    if (input.TypeOfInput == -1) {
+        error = "missing or unknown mode";
+        return false;
+    }
+    if (input.TypeOfInput == UNSUBSCRIBE) {
+        if (standing.subscription < 0) {
+            error = "missing subscription";
+            return false;
+        }
+        *subscription = standing;
+        return true;
+    }
+    if (standing.subscribe && input.TypeOfInput == ROAD_UPDATE) {
+        error = "only queries can be subscribed to";
+        return false;
+    }
+    if (input.sourceId == -1 || input.destId == -1) {
+        error = "missing source or destination";
+        return false;
+    }
+    if (input.TypeOfInput == 2 && input.maxWalkingTime < 0) {
+        error = "missing maxWalkingTime";
+        return false;
+    }
+    if (input.TypeOfInput == ROAD_UPDATE) *update = times;
+    if (subscription) *subscription = standing;
+    return true;
+}
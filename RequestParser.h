@@ -0,0 +1,72 @@
+/**
+* @file RequestParser.h
+ * @brief Parser for the JSON Lines query protocol
+ */
+
+#ifndef REQUEST_PARSER_H
+#define REQUEST_PARSER_H
+
+#include "FileManager.h"
+
+#include <string_view>
+
+/**
+ * @struct RoadUpdate
+ * @brief New times of the road between two locations, sent as an "update-road" request
+ */
+struct RoadUpdate {
+    int drivingTime = -1;   ///< INF closes the road to cars, -1 keeps the current time
+    int walkingTime = -1;   ///< INF closes the road to pedestrians, -1 keeps the current time
+};
+
+/**
+ * @struct SubscriptionRequest
+ * @brief Subscription fields of a request: "subscribe" on a query, "subscription" on an "unsubscribe" request
+ */
+struct SubscriptionRequest {
+    bool subscribe = false;       ///< Keep the query's result up to date as roads change
+    long long subscription = -1;  ///< Subscription to cancel
+};
+
+/**
+ * @class RequestParser
+ * @brief Reads one JSON query object into an Input without building a document tree
+ * @details A request looks like
+ * {"id":7,"mode":"restricted","source":5,"destination":50,"includeNode":30,
+ *  "avoidNodes":[10,11],"avoidSegments":[[1,2],[20,21]]}
+ * where mode is "driving", "restricted" or "driving-walking" (which also needs
+ * "maxWalkingTime"). "id" is optional, must be a JSON string, number, true, false or
+ * null, and is echoed verbatim in the response. Unknown keys are skipped. Keys and values are compared in place, so the
+ * only allocations are the ones made by the Input's avoid sets.
+ *
+ * A road update looks like
+ * {"id":8,"mode":"update-road","source":1,"destination":2,"drivingTime":null,"walkingTime":5}
+ * where a null time closes the road in that mode and an omitted time is left unchanged.
+ *
+ * A query with "subscribe":true also registers a standing route, and
+ * {"id":9,"mode":"unsubscribe","subscription":4} cancels one.
+ */
+class RequestParser {
+public:
+    static constexpr int ROAD_UPDATE = 3;   ///< Input::TypeOfInput of a road update request
+    static constexpr int UNSUBSCRIBE = 4;   ///< Input::TypeOfInput of an unsubscribe request
+
+    /**
+     * @brief Parses a request line.
+     * @param line One JSON object.
+     * @param input Filled with the query; its avoid sets are cleared first so they can be reused.
+     * @param id Set to the raw text of the "id" value, or an empty view if there is none.
+     * @param error Set to a description of the problem when parsing fails.
+     * @param update Receives the times of a road update, whose input then has TypeOfInput
+     * ROAD_UPDATE and the road's ends as source and destination. Without it road updates
+     * are rejected as an unknown mode.
+     * @param subscription Receives the subscription fields. An unsubscribe request has TypeOfInput
+     * UNSUBSCRIBE and needs no source or destination. Without it both are rejected.
+     * @return True if the line is a valid request.
+     * @complexity O(L) where L is the length of the line.
+     */
+    static bool parse(std::string_view line, Input& input, std::string_view& id, const char*& error,
+                      RoadUpdate* update = nullptr, SubscriptionRequest* subscription = nullptr);
+};
+
+#endif // REQUEST_PARSER_H
@@ -0,0 +1,131 @@
+#include "ResultReader.h"
+#include "ResultWriter.h"
+#include <cstring>
+#include <iostream>
+
+bool ResultReader::open(const std::string& filename) {
+    if (!file.open(filename)) {
+        std::cerr << "Error: Unable to open " << filename << std::endl;
+        return false;
+    }
+    file.advise(MappedFile::Access::Sequential);
+    if (!attach(file.view())) {
+        std::cerr << "Error: " << filename << " is not a binary result file" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ResultReader::attach(std::string_view bytes) {
+    BinaryResultHeader header;
+    corrupt = false;
+    position = end = nullptr;
+    if (bytes.size() < sizeof(header)) return false;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, BinaryResultHeader::MAGIC, sizeof(header.magic)) != 0
+        || header.version != BinaryResultHeader::VERSION) {
+        return false;
+    }
+    position = bytes.data() + sizeof(header);
+    end = bytes.data() + bytes.size();
+    return true;
+}
+
+bool ResultReader::readRecord(std::string_view record, Output& output) {
+    corrupt = false;
+    position = record.data();
+    end = record.data() + record.size();
+    return next(output) && position == end;
+}
+
+bool ResultReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && position < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*position++);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool ResultReader::readSigned(int& value) {
+    uint64_t code;
+    if (!readVarint(code)) return false;
+    value = static_cast<int>(static_cast<int64_t>(code >> 1) ^ -static_cast<int64_t>(code & 1));
+    return true;
+}
+
+bool ResultReader::readPath(std::vector<int>& path) {
+    uint64_t length;
+    // Every ID takes at least one byte, which bounds the allocation for corrupt lengths
+    if (!readVarint(length) || length > uint64_t(end - position)) return false;
+    path.resize(length);
+    int previous = 0;
+    for (int& id : path) {
+        int delta;
+        if (!readSigned(delta)) return false;
+        id = previous + delta;
+        previous = id;
+    }
+    return true;
+}
+
+bool ResultReader::readRoute(std::pair<std::vector<int>, int>& route) {
+    if (!readPath(route.first)) return false;
+    route.second = 0;
+    return route.first.empty() || readSigned(route.second);
+}
+
+bool ResultReader::decode(Output& output) {
+    if (end - position < 2) return false;
+    output.TypeOfInput = static_cast<uint8_t>(*position++);
+    output.hasSuggestions = (*position++ & 1) != 0;
+    output.suggestions.clear();
+    output.bestPath = {};
+    output.altPath = {};
+    output.parkingNode = -1;
+    output.totalTime = 0;
+    output.maxWalkingTime = -1;
+    if (!readSigned(output.sourceId) || !readSigned(output.destId)) return false;
+
+    if (output.TypeOfInput == 0) return readRoute(output.bestPath) && readRoute(output.altPath);
+    if (output.TypeOfInput == 1) return readRoute(output.bestPath);
+    if (output.TypeOfInput != 2 || !readSigned(output.maxWalkingTime)) return false;
+    if (!output.hasSuggestions) {
+        return readRoute(output.bestPath) && readSigned(output.parkingNode)
+               && readRoute(output.altPath) && readSigned(output.totalTime);
+    }
+
+    uint64_t count;
+    if (!readVarint(count) || count == 0 || count > uint64_t(end - position)) return false;
+    output.suggestions.resize(count);
+    for (Suggestion& suggestion : output.suggestions) {
+        if (!readPath(suggestion.drivePath) || !readPath(suggestion.walkPath)
+            || !readSigned(suggestion.parkingNode) || !readSigned(suggestion.totalTime)
+            || !readSigned(suggestion.walkingTime) || !readSigned(suggestion.exceedWalkingBy)) {
+            return false;
+        }
+    }
+    const Suggestion& first = output.suggestions[0];
+    output.bestPath = {first.drivePath, first.totalTime - first.walkingTime};
+    output.altPath = {first.walkPath, first.walkingTime};
+    output.parkingNode = first.parkingNode;
+    output.totalTime = first.totalTime;
+    return true;
+}
+
+bool ResultReader::next(Output& output) {
+    if (corrupt || position == end) return false;
+    uint64_t size;
+    if (!readVarint(size) || size > uint64_t(end - position)) {
+        corrupt = true;
+        return false;
+    }
+    const char* streamEnd = end;
+    const char* recordEnd = position + size;
+    end = recordEnd;
+    corrupt = !decode(output) || position != recordEnd;
+    position = recordEnd;
+    end = streamEnd;
+    return !corrupt;
+}
@@ -0,0 +1,68 @@
+/**
+* @file ResultReader.h
+ * @brief Decoder for binary result streams
+ */
+
+#ifndef RESULT_READER_H
+#define RESULT_READER_H
+
+#include "FileManager.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @class ResultReader
+ * @brief Decodes the records written by ResultWriter in binary format
+ * @details The stream is read in place from a mapped file or a caller-owned buffer.
+ * Decoded Outputs match the ones that were written, with the best and alternative
+ * routes of a suggestion record filled from its first suggestion as the planner does.
+ */
+class ResultReader {
+public:
+    /**
+     * @brief Maps a binary result file and checks its header.
+     * @return True if the file is a binary result stream of a supported version.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Reads a binary result stream held in memory, which must outlive the reader.
+     * @return True if the header is valid.
+     */
+    bool attach(std::string_view bytes);
+
+    /**
+     * @brief Decodes a single record made by ResultWriter::encode().
+     * @return False if the record is corrupt.
+     */
+    bool readRecord(std::string_view record, Output& output);
+
+    /**
+     * @brief Decodes the next result.
+     * @return False at the end of the stream or on a corrupt record (see failed()).
+     * @complexity O(N) where N is the total length of the record's paths.
+     */
+    bool next(Output& output);
+
+    /**
+     * @brief Check if decoding stopped on a corrupt or truncated record.
+     */
+    bool failed() const { return corrupt; }
+
+private:
+    bool readVarint(uint64_t& value);
+    bool readSigned(int& value);
+    bool readPath(std::vector<int>& path);
+    bool readRoute(std::pair<std::vector<int>, int>& route);
+    bool decode(Output& output);
+
+    MappedFile file;            ///< Mapping when opened from a file
+    const char* position = nullptr;   ///< Next byte to decode
+    const char* end = nullptr;        ///< End of the stream, or of the current record while decoding
+    bool corrupt = false;       ///< A record could not be decoded
+};
+
+#endif // RESULT_READER_H
@@ -0,0 +1,376 @@
+#include "ResultWriter.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+ResultWriter::~ResultWriter() { close(); }
+
+bool ResultWriter::open(const std::string& name, bool append, Format encoding) {
+    close();
+    filename = name;
+    format = encoding;
+    failed = false;
+    if (name == "-") {
+        file = stdout;
+        ownsFile = false;
+    } else {
+        file = std::fopen(name.c_str(), append ? "ab" : "wb");
+        if (!file) {
+            std::cerr << "Error: Unable to open " << name << std::endl;
+            return false;
+        }
+        ownsFile = true;
+        std::setvbuf(file, nullptr, _IONBF, 0); // Blocks are already buffered here
+    }
+    if (format == Format::Binary && (!ownsFile || (std::fseek(file, 0, SEEK_END) == 0 && std::ftell(file) == 0))) {
+        BinaryResultHeader header{};
+        std::memcpy(header.magic, BinaryResultHeader::MAGIC, sizeof(header.magic));
+        header.version = BinaryResultHeader::VERSION;
+        buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    return true;
+}
+
+bool ResultWriter::flush() {
+    if (!file) return false;
+    if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        if (!failed) std::cerr << "Error: Unable to write " << filename << std::endl;
+        failed = true;
+    }
+    buffer.clear();
+    if (!ownsFile) std::fflush(file);
+    return !failed;
+}
+
+bool ResultWriter::close() {
+    if (!file) return true;
+    bool ok = flush();
+    if (ownsFile) std::fclose(file);
+    file = nullptr;
+    return ok;
+}
+
+void ResultWriter::write(std::string_view text) {
+    if (format != Format::Text) return;
+    buffer.append(text);
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void ResultWriter::appendInt(long long value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer.append(digits, end);
+}
+
+void ResultWriter::appendPath(const std::vector<int>& path) {
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i > 0) buffer.push_back(',');
+        appendInt(path[i]);
+    }
+}
+
+void ResultWriter::appendRoute(const std::pair<std::vector<int>, int>& route) {
+    if (route.first.empty()) {
+        buffer.append("none\n");
+        return;
+    }
+    appendPath(route.first);
+    buffer.append(" (");
+    appendInt(route.second);
+    buffer.append(" min)\n");
+}
+
+void ResultWriter::write(const Output& output) {
+    if (format == Format::Binary) writeBinary(output);
+    else if (format == Format::Json) writeJson(output, {});
+    else writeText(output);
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void ResultWriter::appendVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+void ResultWriter::appendSigned(int64_t value) {
+    appendVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void ResultWriter::appendPathCode(const std::vector<int>& path) {
+    appendVarint(path.size());
+    int64_t previous = 0;
+    for (int id : path) {
+        appendSigned(id - previous);
+        previous = id;
+    }
+}
+
+void ResultWriter::appendRouteCode(const std::pair<std::vector<int>, int>& route) {
+    appendPathCode(route.first);
+    if (!route.first.empty()) appendSigned(route.second);
+}
+
+void ResultWriter::writeBinary(const Output& output) {
+    // The payload is encoded after the record start, then its size is inserted in front
+    size_t start = buffer.size();
+    buffer.push_back(static_cast<char>(output.TypeOfInput));
+    buffer.push_back(static_cast<char>(output.hasSuggestions ? 1 : 0));
+    appendSigned(output.sourceId);
+    appendSigned(output.destId);
+    if (output.TypeOfInput == 0) {
+        appendRouteCode(output.bestPath);
+        appendRouteCode(output.altPath);
+    } else if (output.TypeOfInput == 1) {
+        appendRouteCode(output.bestPath);
+    } else {
+        appendSigned(output.maxWalkingTime);
+        if (!output.hasSuggestions) {
+            appendRouteCode(output.bestPath);
+            appendSigned(output.parkingNode);
+            appendRouteCode(output.altPath);
+            appendSigned(output.totalTime);
+        } else {
+            size_t listed = std::min<size_t>(2, output.suggestions.size());
+            appendVarint(listed);
+            for (size_t i = 0; i < listed; i++) {
+                const auto& suggestion = output.suggestions[i];
+                appendPathCode(suggestion.drivePath);
+                appendPathCode(suggestion.walkPath);
+                appendSigned(suggestion.parkingNode);
+                appendSigned(suggestion.totalTime);
+                appendSigned(suggestion.walkingTime);
+                appendSigned(suggestion.exceedWalkingBy);
+            }
+        }
+    }
+    size_t payload = buffer.size() - start;
+    char prefix[10];
+    size_t length = 0;
+    for (uint64_t value = payload; ; value >>= 7) {
+        prefix[length++] = static_cast<char>(value >= 0x80 ? (value & 0x7f) | 0x80 : value);
+        if (value < 0x80) break;
+    }
+    buffer.insert(start, prefix, length);
+}
+
+void ResultWriter::writeText(const Output& output) {
+    buffer.append("Source:");
+    appendInt(output.sourceId);
+    buffer.append("\nDestination:");
+    appendInt(output.destId);
+    buffer.push_back('\n');
+
+    if (output.TypeOfInput == 0) {
+        buffer.append("BestDrivingRoute:");
+        appendRoute(output.bestPath);
+        buffer.append("AlternativeRoute:");
+        appendRoute(output.altPath);
+    }
+
+    if (output.TypeOfInput == 1) {
+        buffer.append("RestrictedDrivingRoute:");
+        appendRoute(output.bestPath);
+    }
+
+    if (output.TypeOfInput == 2) {
+        // Case 1: No route found at all
+        if (output.bestPath.first.empty() && output.altPath.first.empty() &&
+            output.parkingNode == -1 && !output.hasSuggestions) {
+            buffer.append("DrivingRoute:none\nParkingNode:none\nWalkingRoute:none\nTotalTime:none\n"
+                          "Message:No possible route with max walking time of ");
+            appendInt(output.maxWalkingTime);
+            buffer.append(" minutes.\n");
+        }
+        // Case 2: Found exact route (within walking limit)
+        else if (!output.hasSuggestions) {
+            buffer.append("DrivingRoute:");
+            appendRoute(output.bestPath);
+            buffer.append("ParkingNode:");
+            appendInt(output.parkingNode);
+            buffer.append("\nWalkingRoute:");
+            appendRoute(output.altPath);
+            buffer.append("TotalTime:");
+            appendInt(output.totalTime);
+            buffer.push_back('\n');
+        }
+        // Case 3: Only have suggestions (exceed walking time), the two fastest are listed
+        else {
+            size_t listed = std::min<size_t>(2, output.suggestions.size());
+            for (size_t i = 0; i < listed; i++) {
+                const auto& suggestion = output.suggestions[i];
+                buffer.append("DrivingRoute");
+                appendInt(static_cast<long long>(i + 1));
+                buffer.push_back(':');
+                appendPath(suggestion.drivePath);
+                buffer.append(" (");
+                appendInt(suggestion.totalTime - suggestion.walkingTime);
+                buffer.append(" min)\nParkingNode");
+                appendInt(static_cast<long long>(i + 1));
+                buffer.push_back(':');
+                appendInt(suggestion.parkingNode);
+                buffer.append(" \nWalkingRoute1:");
+                appendPath(suggestion.walkPath);
+                buffer.append(" (");
+                appendInt(suggestion.walkingTime);
+                buffer.append(" min)(Exceeds by ");
+                appendInt(suggestion.exceedWalkingBy);
+                buffer.append(" min)\nTotalTime");
+                appendInt(static_cast<long long>(i + 1));
+                buffer.push_back(':');
+                appendInt(suggestion.totalTime);
+                buffer.push_back('\n');
+            }
+        }
+    }
+    if (withStats) appendStats(output.stats, false);
+}
+
+void ResultWriter::appendJsonRoute(const std::vector<int>& path, int time) {
+    if (path.empty()) {
+        buffer.append("null");
+        return;
+    }
+    buffer.append("{\"path\":[");
+    appendPath(path);
+    buffer.append("],\"time\":");
+    appendInt(time);
+    buffer.push_back('}');
+}
+
+void ResultWriter::appendJsonId(std::string_view id) {
+    buffer.push_back('{');
+    if (id.empty()) return;
+    buffer.append("\"id\":");
+    buffer.append(id);
+    buffer.push_back(',');
+}
+
+void ResultWriter::writeJson(const Output& output, std::string_view id) {
+    appendJsonId(id);
+    appendJsonResult(output);
+}
+
+void ResultWriter::writeJsonPush(uint64_t subscription, uint64_t version, const Output* output) {
+    buffer.append("{\"subscription\":");
+    appendInt(static_cast<long long>(subscription));
+    buffer.append(",\"version\":");
+    appendInt(static_cast<long long>(version));
+    buffer.push_back(',');
+    if (output) {
+        appendJsonResult(*output);
+        return;
+    }
+    buffer.append("\"ok\":false,\"error\":\"no route for this query\"}\n");
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void ResultWriter::appendJsonResult(const Output& output) {
+    static const char* const MODES[] = {"driving", "restricted", "driving-walking"};
+    buffer.append("\"ok\":true,\"mode\":\"");
+    buffer.append(MODES[output.TypeOfInput]);
+    buffer.append("\",\"source\":");
+    appendInt(output.sourceId);
+    buffer.append(",\"destination\":");
+    appendInt(output.destId);
+
+    if (output.TypeOfInput == 0) {
+        buffer.append(",\"best\":");
+        appendJsonRoute(output.bestPath.first, output.bestPath.second);
+        buffer.append(",\"alternative\":");
+        appendJsonRoute(output.altPath.first, output.altPath.second);
+    } else if (output.TypeOfInput == 1) {
+        buffer.append(",\"best\":");
+        appendJsonRoute(output.bestPath.first, output.bestPath.second);
+    } else {
+        buffer.append(",\"maxWalkingTime\":");
+        appendInt(output.maxWalkingTime);
+        if (!output.hasSuggestions) {
+            bool found = output.parkingNode != -1 && !output.bestPath.first.empty();
+            buffer.append(",\"driving\":");
+            appendJsonRoute(output.bestPath.first, output.bestPath.second);
+            buffer.append(",\"parkingNode\":");
+            if (found) appendInt(output.parkingNode);
+            else buffer.append("null");
+            buffer.append(",\"walking\":");
+            appendJsonRoute(output.altPath.first, output.altPath.second);
+            buffer.append(",\"totalTime\":");
+            if (found) appendInt(output.totalTime);
+            else buffer.append("null");
+        } else {
+            // The two fastest suggestions, as in the text format
+            buffer.append(",\"suggestions\":[");
+            size_t listed = std::min<size_t>(2, output.suggestions.size());
+            for (size_t i = 0; i < listed; i++) {
+                const auto& suggestion = output.suggestions[i];
+                if (i > 0) buffer.push_back(',');
+                buffer.append("{\"driving\":");
+                appendJsonRoute(suggestion.drivePath, suggestion.totalTime - suggestion.walkingTime);
+                buffer.append(",\"parkingNode\":");
+                appendInt(suggestion.parkingNode);
+                buffer.append(",\"walking\":");
+                appendJsonRoute(suggestion.walkPath, suggestion.walkingTime);
+                buffer.append(",\"exceedsBy\":");
+                appendInt(suggestion.exceedWalkingBy);
+                buffer.append(",\"totalTime\":");
+                appendInt(suggestion.totalTime);
+                buffer.push_back('}');
+            }
+            buffer.push_back(']');
+        }
+    }
+    if (withStats) appendStats(output.stats, true);
+    buffer.append("}\n");
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void ResultWriter::writeJsonError(std::string_view id, std::string_view message) {
+    appendJsonId(id);
+    buffer.append("\"ok\":false,\"error\":\"");
+    buffer.append(message);
+    buffer.append("\"}\n");
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void ResultWriter::writeJsonVersion(std::string_view id, uint64_t version) {
+    appendJsonId(id);
+    buffer.append("\"ok\":true,\"version\":");
+    appendInt(static_cast<long long>(version));
+    buffer.append("}\n");
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void ResultWriter::writeJsonSubscription(std::string_view id, uint64_t subscription) {
+    appendJsonId(id);
+    buffer.append("\"ok\":true,\"subscription\":");
+    appendInt(static_cast<long long>(subscription));
+    buffer.append("}\n");
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void ResultWriter::encode(const Output& output, std::string& record) {
+    ResultWriter encoder;
+    encoder.buffer.swap(record);
+    encoder.buffer.clear();
+    encoder.writeBinary(output);
+    record.swap(encoder.buffer);
+}
+
+void ResultWriter::appendStats(const SearchStats& stats, bool json) {
+    const std::pair<const char*, uint64_t> counters[] = {
+        {"settled", stats.settled}, {"relaxed", stats.relaxed}, {"pushes", stats.pushes},
+        {"pops", stats.pops}, {"stalePops", stats.stalePops}, {"blockedSkips", stats.blockedSkips},
+        {"parkingCandidates", stats.parkingCandidates}};
+    buffer.append(json ? ",\"stats\":{" : "SearchStats:");
+    for (size_t i = 0; i < std::size(counters); ++i) {
+        if (i > 0) buffer.push_back(',');
+        if (json) buffer.push_back('"');
+        buffer.append(counters[i].first);
+        buffer.append(json ? "\":" : "=");
+        appendInt(static_cast<long long>(counters[i].second));
+    }
+    buffer.append(json ? "}" : "\n");
+}
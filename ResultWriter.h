@@ -0,0 +1,162 @@
+/**
+* @file ResultWriter.h
+ * @brief Buffered serializer for route planning results
+ */
+
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include "FileManager.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct BinaryResultHeader
+ * @brief Fixed header at the start of a binary result stream
+ * @details It is followed by one record per result: the record's payload size as a
+ * varint, then the mode and flag bytes (bit 0: suggestions), then source and destination.
+ * The rest depends on the mode. Driving records hold the best and alternative routes.
+ * Restricted records hold the best route. Driving-walking records hold the maximum
+ * walking time, then either the driving route, parking node, walking route and total
+ * time, or the number of suggestions (at most the two listed in text) followed by each suggestion's driving path,
+ * walking path, parking node, total time, walking time and excess walking time.
+ * A path is its length as a varint followed by its first ID and the differences
+ * between consecutive IDs; a route is a path followed by its time when non-empty.
+ * Signed values are zigzag varints.
+ */
+struct BinaryResultHeader {
+    static constexpr char MAGIC[8] = {'R', 'T', 'R', 'E', 'S', 'U', 'L', 'T'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];       ///< MAGIC
+    uint32_t version;    ///< VERSION
+    uint32_t reserved;   ///< Zero
+};
+
+/**
+ * @class ResultWriter
+ * @brief Formats Output records into a reusable byte buffer and writes it in large blocks
+ * @details Integers are formatted with std::to_chars. A writer can target a file, truncated
+ * or appended to, or stdout ("-"), so many results can be streamed into one destination.
+ */
+class ResultWriter {
+public:
+    /**
+     * @brief Encoding of the results.
+     */
+    enum class Format { Text, Binary, Json };
+
+    static constexpr size_t FLUSH_BYTES = 1 << 20;   ///< Buffer size that triggers a write
+
+    ResultWriter() = default;
+    ~ResultWriter();
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    /**
+     * @brief Opens the destination, closing the previous one.
+     * @param filename File to write, or "-" for stdout.
+     * @param append Append to the file instead of truncating it.
+     * @param format Text writes the output.txt format, Binary a BinaryResultHeader stream
+     * (the header is only written when the file is empty) and Json one object per line.
+     * @return True on success; errors are reported on cerr.
+     */
+    bool open(const std::string& filename, bool append = false, Format format = Format::Text);
+
+    /**
+     * @brief Also writes each result's search statistics: a SearchStats line in text,
+     * a "stats" member in JSON. The binary format does not carry them.
+     */
+    void includeStats(bool include) { withStats = include; }
+
+    /**
+     * @brief Writes one result in the format chosen by open().
+     * @complexity O(N) where N is the total length of the paths.
+     */
+    void write(const Output& output);
+
+    /**
+     * @brief Writes one result as a single-line JSON object, whatever the format.
+     * @details Routes are {"path":[...],"time":T} objects, or null when there is none.
+     * @param id Raw JSON value echoed as the "id" member, omitted if empty.
+     * @complexity O(N) where N is the total length of the paths.
+     */
+    void writeJson(const Output& output, std::string_view id);
+
+    /**
+     * @brief Writes a failed request as {"id":...,"ok":false,"error":"message"} on one line.
+     * @param message Plain text that needs no JSON escaping.
+     */
+    void writeJsonError(std::string_view id, std::string_view message);
+
+    /**
+     * @brief Writes a successful request that returns no route as {"id":...,"ok":true,"version":V} on one line.
+     */
+    void writeJsonVersion(std::string_view id, uint64_t version);
+
+    /**
+     * @brief Writes an accepted subscribe or unsubscribe request as {"id":...,"ok":true,"subscription":N} on one line.
+     */
+    void writeJsonSubscription(std::string_view id, uint64_t subscription);
+
+    /**
+     * @brief Writes a subscription's new result, as writeJson() does but led by
+     * "subscription" and the graph "version" it was computed at instead of an id.
+     * @param output The result, or nullptr if the query no longer has a route.
+     * @complexity O(N) where N is the total length of the paths.
+     */
+    void writeJsonPush(uint64_t subscription, uint64_t version, const Output* output);
+
+    /**
+     * @brief Encodes one result as a binary record, without the stream header.
+     * @details ResultReader::readRecord() decodes it; used to keep results compactly in memory.
+     */
+    static void encode(const Output& output, std::string& record);
+
+    /**
+     * @brief Writes raw text, e.g. a separator between batch results. Ignored unless the format is Text.
+     */
+    void write(std::string_view text);
+
+    /**
+     * @brief Writes the buffered bytes to the destination.
+     * @return False if the write failed.
+     */
+    bool flush();
+
+    /**
+     * @brief Flushes and closes the destination. The buffer is kept for reuse.
+     * @return False if any write failed.
+     */
+    bool close();
+
+private:
+    void writeText(const Output& output);
+    void writeBinary(const Output& output);
+    void appendVarint(uint64_t value);
+    void appendSigned(int64_t value);
+    void appendPathCode(const std::vector<int>& path);
+    void appendRouteCode(const std::pair<std::vector<int>, int>& route);
+    void appendJsonRoute(const std::vector<int>& path, int time);
+    void appendJsonId(std::string_view id);
+    void appendJsonResult(const Output& output);
+    void appendStats(const SearchStats& stats, bool json);
+    void appendInt(long long value);
+    void appendPath(const std::vector<int>& path);
+    void appendRoute(const std::pair<std::vector<int>, int>& route);
+
+    std::string buffer;           ///< Formatted bytes not yet written
+    Format format = Format::Text; ///< Encoding chosen by open()
+    std::FILE* file = nullptr;    ///< Destination
+    bool ownsFile = false;        ///< False for stdout
+    bool failed = false;          ///< A write failed since open()
+    bool withStats = false;       ///< Write search statistics with each result
+    std::string filename;         ///< Destination name, for error messages
+};
+
+#endif // RESULT_WRITER_H
@@ -0,0 +1,369 @@
+/**
+* @file RouteBench.cpp
+ * @brief Benchmark of the search engines on synthetic road networks
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AllPairsTable.h"
+#include "BenchBaseline.h"
+#include "CompressedGraph.h"
+#include "FileManager.h"
+#include "GraphSnapshot.h"
+#include "LandmarkIndex.h"
+#include "NetworkGenerator.h"
+#include "PerfCounters.h"
+#include "QueryReplay.h"
+#include "RoutePlanner.h"
+#include "RouteVerifier.h"
+#include "SearchEngine.h"
+using namespace std;
+
+/**
+ * @struct BenchOptions
+ * @brief Command line settings of a benchmark run
+ */
+struct BenchOptions {
+    string generator = "grid";
+    uint32_t nodes = 10000;
+    double parkingDensity = 0.05;
+    uint64_t seed = 1;
+    uint32_t queries = 200;
+    uint32_t landmarks = 16;
+    uint32_t matrixSize = 8;
+    uint32_t allPairsLimit = 2048;   ///< Largest network the all-pairs engine builds tables for
+    vector<string> engines = {"reference", "snapshot", "alt", "compressed"};
+    vector<string> workloads = {"normal", "restricted", "multimodal", "matrix"};
+    bool perfCounters = false;   ///< Report hardware events per engine and search phase
+    uint32_t verifyRounds = 0;   ///< Check the engines against the reference instead of timing them
+    string reproPrefix = "verify_";
+    uint32_t repeat = 1;         ///< Runs of each workload on each engine
+    string saveBaseline;         ///< Baseline file the results are written to
+    string baseline;             ///< Baseline file the results are compared with
+    double threshold = 0.10;     ///< Tolerated relative slowdown against the baseline
+    ReplayOptions replay;        ///< Replays a query log instead of the synthetic workloads when its file is set
+};
+
+/**
+ * @struct Workload
+ * @brief A named list of queries, run identically on every engine
+ * @details Multimodal and matrix queries are far more expensive than point-to-point
+ * ones, so their workloads hold fewer queries.
+ */
+struct Workload {
+    string name;
+    vector<Input> queries;
+};
+
+/**
+ * @struct Latencies
+ * @brief Query times of one workload on one engine
+ */
+struct Latencies {
+    vector<double> milliseconds;
+    double totalSeconds = 0;
+    size_t failed = 0;
+
+    double percentile(double p) const {
+        if (milliseconds.empty()) return 0;
+        vector<double> sorted = milliseconds;
+        size_t rank = min(sorted.size() - 1, static_cast<size_t>(p * double(sorted.size())));
+        nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+};
+
+/**
+ * @brief splitmix64 step, so the queries only depend on the seed.
+ */
+uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Generates the queries of one workload.
+ * @details Matrix queries use TypeOfInput -1; their source and destination only seed
+ * the choice of the matrix locations, see solveMatrix().
+ */
+Workload makeWorkload(const string& name, const BenchOptions& options, int locationCount) {
+    uint64_t state = options.seed * 0x2545f4914f6cdd1dULL + name.size();
+    auto randomId = [&] { return 1 + static_cast<int>(nextRandom(state) % uint64_t(locationCount)); };
+
+    Workload workload{name, {}};
+    uint32_t count = options.queries;
+    if (name == "multimodal" || name == "matrix") count = max<uint32_t>(5, options.queries / 10);
+    for (uint32_t q = 0; q < count; ++q) {
+        Input input;
+        input.sourceId = randomId();
+        input.destId = randomId();
+        if (name == "normal") {
+            input.TypeOfInput = 0;
+        } else if (name == "restricted") {
+            input.TypeOfInput = 1;
+            input.includeNodeId = randomId();
+            for (int i = 0; i < 4; ++i) input.avoidNodes.insert(randomId());
+            input.avoidNodes.erase(input.sourceId);
+            input.avoidNodes.erase(input.destId);
+            input.avoidNodes.erase(input.includeNodeId);
+        } else if (name == "multimodal") {
+            input.TypeOfInput = 2;
+            input.maxWalkingTime = 10 + static_cast<int>(nextRandom(state) % 51);
+        } else {
+            input.TypeOfInput = -1;
+        }
+        workload.queries.push_back(std::move(input));
+    }
+    return workload;
+}
+
+/**
+ * @brief Answers every matrix entry between matrixSize locations drawn from the query.
+ * @return False if any pair is unreachable.
+ */
+bool solveMatrix(SearchEngine& engine, const Input& query, uint32_t matrixSize, int locationCount) {
+    uint64_t state = uint64_t(query.sourceId) * 31 + uint64_t(query.destId);
+    vector<int> ids(2 * matrixSize);
+    for (int& id : ids) id = 1 + static_cast<int>(nextRandom(state) % uint64_t(locationCount));
+    bool complete = true;
+    for (uint32_t s = 0; s < matrixSize; ++s) {
+        for (uint32_t t = 0; t < matrixSize; ++t) {
+            unordered_set<int> avoidNodes;
+            unordered_set<pair<int, int>, pair_hash> avoidSegments;
+            if (engine.findPath(ids[s], ids[matrixSize + t], true, avoidNodes, avoidSegments).first.empty()) complete = false;
+        }
+    }
+    return complete;
+}
+
+/**
+ * @brief Times every query of a workload on one engine.
+ */
+Latencies runWorkload(SearchEngine& engine, const Workload& workload, const BenchOptions& options, int locationCount,
+                      PerfProfile* counters) {
+    Latencies latencies;
+    latencies.milliseconds.reserve(workload.queries.size());
+    // The planners report unanswerable queries on cerr; keep the report readable
+    streambuf* errors = cerr.rdbuf(nullptr);
+    PerfProfile::Scope counting(counters, engine.name());
+    auto start = chrono::steady_clock::now();
+    for (const Input& query : workload.queries) {
+        Input input = query; // The planners extend the avoided segments
+        Output output;
+        auto before = chrono::steady_clock::now();
+        bool answered = input.TypeOfInput == -1 ? solveMatrix(engine, input, options.matrixSize, locationCount)
+                                                : RoutePlanner::solve(engine, input, output)
+                                                  && !output.bestPath.first.empty();
+        auto after = chrono::steady_clock::now();
+        latencies.milliseconds.push_back(chrono::duration<double, milli>(after - before).count());
+        if (!answered) ++latencies.failed;
+    }
+    latencies.totalSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr.clear();
+    cerr.rdbuf(errors);
+    return latencies;
+}
+
+/**
+ * @brief Splits a comma-separated list.
+ */
+vector<string> splitList(const string& list) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ',')) if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--perf-counters") {
+            options.perfCounters = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (arg == "--generator") options.generator = value;
+        else if (arg == "--nodes") options.nodes = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--parking") options.parkingDensity = stod(value);
+        else if (arg == "--seed") options.seed = stoull(value);
+        else if (arg == "--queries") options.queries = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--landmarks") options.landmarks = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--matrix-size") options.matrixSize = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--all-pairs-limit") options.allPairsLimit = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--engines") options.engines = splitList(value);
+        else if (arg == "--workloads") options.workloads = splitList(value);
+        else if (arg == "--verify") options.verifyRounds = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--repro") options.reproPrefix = value;
+        else if (arg == "--repeat") options.repeat = max<uint32_t>(1, static_cast<uint32_t>(stoul(value)));
+        else if (arg == "--save-baseline") options.saveBaseline = value;
+        else if (arg == "--baseline") options.baseline = value;
+        else if (arg == "--threshold") options.threshold = stod(value);
+        else if (arg == "--replay") options.replay.logFile = value;
+        else if (arg == "--snapshot") options.replay.snapshotFile = value;
+        else if (arg == "--locations") options.replay.locationsFile = value;
+        else if (arg == "--distances") options.replay.distancesFile = value;
+        else if (arg == "--cache") options.replay.cacheEntries = stoul(value);
+        else if (arg == "--tree-cache") options.replay.treeCacheBytes = static_cast<size_t>(stod(value) * 1024 * 1024);
+        else if (arg == "--threads") options.replay.threads = static_cast<unsigned>(stoul(value));
+        else if (arg == "--speed" && (value == "recorded" || value == "max")) options.replay.recordedSpeed = value == "recorded";
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        cerr << "Usage: " << argv[0] << " [--generator grid|geometric|hierarchical] [--nodes <count>]"
+             << " [--parking <density>] [--seed <seed>] [--queries <count>] [--landmarks <count>]"
+             << " [--matrix-size <count>] [--engines reference,snapshot,alt,compressed,all-pairs]"
+             << " [--all-pairs-limit <locations>]"
+             << " [--workloads normal,restricted,multimodal,matrix] [--perf-counters]"
+             << " [--repeat <runs>] [--save-baseline <file>] [--baseline <file> [--threshold <fraction>]]"
+             << " [--verify <rounds> [--repro <file prefix>]]"
+             << " [--replay <query log> [--snapshot <file> | --locations <file> --distances <file>]"
+             << " [--threads <count>] [--speed recorded|max] [--cache <entries>] [--tree-cache <MiB>]]" << endl;
+        return 1;
+    }
+
+    if (options.verifyRounds > 0) {
+        VerifyOptions verify;
+        verify.seed = options.seed;
+        verify.rounds = options.verifyRounds;
+        verify.reproPrefix = options.reproPrefix;
+        // The reference engine is the oracle; checking it against itself proves nothing
+        verify.engines.clear();
+        for (const string& name : options.engines) if (name != "reference") verify.engines.push_back(name);
+        return RouteVerifier::run(verify, cout) ? 0 : 1;
+    }
+
+    if (!options.replay.logFile.empty()) {
+        options.replay.engines = options.engines;
+        options.replay.landmarks = options.landmarks;
+        options.replay.allPairsLimit = options.allPairsLimit;
+        return QueryReplay::run(options.replay, cout) ? 0 : 1;
+    }
+
+    vector<BenchResult> baseline;
+    if (!options.baseline.empty() && !BenchBaseline::load(options.baseline, baseline)) return 1;
+
+    Graph graph;
+    if (!NetworkGenerator::generate(&graph, options.generator, options.nodes, options.parkingDensity, options.seed)) {
+        cerr << "Error: Unknown generator " << options.generator << endl;
+        return 1;
+    }
+    GraphSnapshot snapshot = GraphSnapshot::fromGraph(graph);
+    int locationCount = static_cast<int>(snapshot.nodeCount());
+    cout << "Graph: " << options.generator << ", " << snapshot.nodeCount() << " locations, "
+         << snapshot.edgeCount() / 2 << " roads, parking density " << options.parkingDensity
+         << ", seed " << options.seed << endl;
+
+    LandmarkIndex landmarks;
+    CompressedGraph compressed;
+    AllPairsTable allPairs;
+    vector<unique_ptr<SearchEngine>> engines;
+    for (const string& name : options.engines) {
+        if (name == "reference") engines.push_back(make_unique<ReferenceEngine>(graph));
+        else if (name == "snapshot") engines.push_back(make_unique<SnapshotEngine>(snapshot));
+        else if (name == "alt") {
+            landmarks = LandmarkIndex::build(snapshot, options.landmarks);
+            engines.push_back(make_unique<SnapshotEngine>(snapshot, &landmarks));
+        } else if (name == "compressed") {
+            compressed = CompressedGraph::build(snapshot);
+            engines.push_back(make_unique<CompressedEngine>(compressed));
+        } else if (name == "all-pairs") {
+            // The tables take 12 bytes per pair of locations, about 51 GB at MAX_NODES
+            uint32_t limit = min(options.allPairsLimit, AllPairsTable::MAX_NODES);
+            if (snapshot.nodeCount() > limit) {
+                cerr << "Error: network of " << snapshot.nodeCount() << " locations exceeds the all-pairs limit of "
+                     << limit << endl;
+                return 1;
+            }
+            allPairs = AllPairsTable::build(snapshot);
+            engines.push_back(make_unique<AllPairsEngine>(make_unique<SnapshotEngine>(snapshot), snapshot, allPairs));
+        } else {
+            cerr << "Error: Unknown engine " << name << endl;
+            return 1;
+        }
+    }
+
+    // Opened here, as the workloads silence cerr where the counters would report a failure
+    PerfProfile counters;
+    bool counting = options.perfCounters && PerfProfile::threadCounters();
+
+    ostringstream parking;
+    parking << options.parkingDensity;
+    vector<BenchResult> results;
+
+    cout << left << setw(12) << "workload" << setw(12) << "engine" << right << setw(9) << "queries"
+         << setw(8) << "failed" << setw(12) << "qps" << setw(12) << "p50 (ms)" << setw(12) << "p99 (ms)";
+    if (options.repeat > 1) cout << setw(12) << "mean (ms)" << setw(14) << "95% CI (±%)";
+    cout << endl << fixed;
+    for (const string& name : options.workloads) {
+        if (name != "normal" && name != "restricted" && name != "multimodal" && name != "matrix") {
+            cerr << "Error: Unknown workload " << name << endl;
+            return 1;
+        }
+        Workload workload = makeWorkload(name, options, locationCount);
+        for (auto& engine : engines) {
+            BenchResult result;
+            result.generator = options.generator;
+            result.nodes = options.nodes;
+            result.parking = parking.str();
+            result.seed = options.seed;
+            result.queries = options.queries;
+            result.workload = name;
+            result.engine = engine->name();
+            // Percentiles and throughput are pooled over the runs; the spread comes from the run means
+            Latencies latencies;
+            for (uint32_t run = 0; run < options.repeat; ++run) {
+                Latencies single = runWorkload(*engine, workload, options, locationCount, counting ? &counters : nullptr);
+                result.runMeans.push_back(1000 * single.totalSeconds / double(max<size_t>(workload.queries.size(), 1)));
+                latencies.milliseconds.insert(latencies.milliseconds.end(), single.milliseconds.begin(),
+                                              single.milliseconds.end());
+                latencies.totalSeconds += single.totalSeconds;
+                latencies.failed = single.failed;
+            }
+            result.p50 = latencies.percentile(0.50);
+            result.p99 = latencies.percentile(0.99);
+            cout << left << setw(12) << name << setw(12) << engine->name() << right
+                 << setw(9) << workload.queries.size() << setw(8) << latencies.failed
+                 << setw(12) << setprecision(1) << latencies.milliseconds.size() / max(latencies.totalSeconds, 1e-9)
+                 << setw(12) << setprecision(3) << result.p50 << setw(12) << result.p99;
+            if (options.repeat > 1) {
+                cout << setw(12) << result.mean() << setw(13) << setprecision(1)
+                     << 100 * result.confidence95() / max(result.mean(), 1e-12);
+            }
+            cout << endl;
+            results.push_back(std::move(result));
+        }
+    }
+    if (counting) {
+        cout << endl;
+        counters.writeText(cout);
+    }
+    if (!options.saveBaseline.empty()) {
+        if (!BenchBaseline::save(options.saveBaseline, results)) return 1;
+        cout << endl << "Baseline saved to " << options.saveBaseline << endl;
+    }
+    if (!options.baseline.empty()) {
+        cout << endl << "Compared with " << options.baseline << " (threshold " << setprecision(1)
+             << 100 * options.threshold << "%)" << endl;
+        if (!BenchBaseline::compare(baseline, results, options.threshold, cout)) {
+            cout << "Performance regression" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
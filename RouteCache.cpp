@@ -0,0 +1,305 @@
+#include "RouteCache.h"
+#include "MemoryReport.h"
+#include "ResultReader.h"
+#include "ResultWriter.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+/**
+ * @brief splitmix64 finalizer.
+ */
+uint64_t mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Key of the road between two locations, the same in both directions.
+ */
+uint64_t roadKey(int a, int b) {
+    if (a > b) std::swap(a, b);
+    return uint64_t(static_cast<uint32_t>(a)) << 32 | static_cast<uint32_t>(b);
+}
+
+/**
+ * @brief Calls visit on every path of a result travelled in the given mode.
+ */
+template <typename Visit>
+void forEachPath(const Output& output, bool isDriving, Visit visit) {
+    if (output.TypeOfInput != 2) {
+        if (isDriving) {
+            visit(output.bestPath.first);
+            visit(output.altPath.first);
+        }
+    } else if (!output.hasSuggestions) {
+        visit(isDriving ? output.bestPath.first : output.altPath.first);
+    } else {
+        for (const Suggestion& suggestion : output.suggestions) visit(isDriving ? suggestion.drivePath : suggestion.walkPath);
+    }
+}
+
+/**
+ * @brief Check if a path of a result travelled in the given mode takes a road, in either direction.
+ */
+bool usesRoad(const Output& output, uint64_t road, bool isDriving) {
+    bool found = false;
+    forEachPath(output, isDriving, [&](const std::vector<int>& path) {
+        for (size_t i = 1; i < path.size() && !found; ++i) found = roadKey(path[i - 1], path[i]) == road;
+    });
+    return found;
+}
+
+/**
+ * @brief Sorted keys of the roads a result's paths take, in either mode.
+ */
+std::vector<uint64_t> roadsOf(const Output& output) {
+    std::vector<uint64_t> roads;
+    for (bool isDriving : {true, false}) {
+        forEachPath(output, isDriving, [&](const std::vector<int>& path) {
+            for (size_t i = 1; i < path.size(); ++i) roads.push_back(roadKey(path[i - 1], path[i]));
+        });
+    }
+    std::sort(roads.begin(), roads.end());
+    roads.erase(std::unique(roads.begin(), roads.end()), roads.end());
+    return roads;
+}
+
+} // namespace
+
+RouteCache::RouteCache(size_t capacity, size_t shards)
+    : shardCount(std::max<size_t>(1, std::min(shards, capacity))),
+      slotsPerShard(std::max<size_t>(1, (capacity + shardCount - 1) / shardCount)),
+      shards(new Shard[shardCount]) {
+    for (size_t s = 0; s < shardCount; ++s) this->shards[s].slots.resize(slotsPerShard);
+}
+
+uint64_t RouteCache::fingerprint(const Input& input) {
+    uint64_t hash = 0;
+    auto add = [&](uint64_t value) { hash = mix((hash ^ value) + 0x9e3779b97f4a7c15ULL); };
+    add(static_cast<uint32_t>(input.TypeOfInput));
+    add(static_cast<uint32_t>(input.sourceId));
+    add(static_cast<uint32_t>(input.destId));
+    add(static_cast<uint32_t>(input.maxWalkingTime));
+    add(static_cast<uint32_t>(input.includeNodeId));
+    // Sums of mixed items do not depend on the sets' iteration order
+    uint64_t nodes = 0, segments = 0;
+    for (int id : input.avoidNodes) nodes += mix(static_cast<uint32_t>(id) + 0x632be59bd9b4e019ULL);
+    for (const auto& [from, to] : input.avoidSegments) {
+        segments += mix((uint64_t(static_cast<uint32_t>(from)) << 32 | static_cast<uint32_t>(to)) ^ 0x85157af5ULL);
+    }
+    add(input.avoidNodes.size());
+    add(nodes);
+    add(input.avoidSegments.size());
+    add(segments);
+    return hash;
+}
+
+bool RouteCache::lookup(uint64_t key, Output& output) {
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.guard);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Slot& slot = shard.slots[it->second];
+    ResultReader reader;
+    if (!reader.readRecord(slot.record, output)) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        release(shard, it->second);
+        return false;
+    }
+    slot.referenced = true;
+    output.stats = {};
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void RouteCache::insert(uint64_t key, const Output& output) {
+    std::string record;
+    ResultWriter::encode(output, record);
+    std::vector<uint64_t> roads = roadsOf(output);
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.guard);
+    auto it = shard.index.find(key);
+    uint32_t position;
+    if (it != shard.index.end()) {
+        position = it->second;
+    } else {
+        // CLOCK sweep: referenced slots get a second chance, the first other slot is replaced
+        uint32_t count = static_cast<uint32_t>(shard.slots.size());
+        while (shard.slots[shard.hand].used && shard.slots[shard.hand].referenced) {
+            shard.slots[shard.hand].referenced = false;
+            shard.hand = (shard.hand + 1) % count;
+        }
+        position = shard.hand;
+        shard.hand = (shard.hand + 1) % count;
+        if (shard.slots[position].used) {
+            release(shard, position);
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.index.emplace(key, position);
+    }
+    Slot& slot = shard.slots[position];
+    if (slot.used) shard.liveRoads -= slot.roads;
+    slot.key = key;
+    slot.record = std::move(record);
+    slot.mode = output.TypeOfInput;
+    slot.sourceId = output.sourceId;
+    slot.destId = output.destId;
+    slot.bestTime = output.bestPath.first.empty() ? INF : output.bestPath.second;
+    slot.altTime = output.TypeOfInput != 0 || output.bestPath.first.size() <= 1 ? -1
+                 : output.altPath.first.empty() ? INF : output.altPath.second;
+    slot.roads = static_cast<uint32_t>(roads.size());
+    slot.used = true;
+    slot.referenced = false;
+    for (uint64_t road : roads) shard.postings[road].push_back(position);
+    shard.postingCount += roads.size();
+    shard.liveRoads += roads.size();
+    if (shard.postingCount > 2 * shard.liveRoads + 1024) compactPostings(shard);
+    insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RouteCache::release(Shard& shard, uint32_t position) {
+    Slot& slot = shard.slots[position];
+    shard.index.erase(slot.key);
+    shard.liveRoads -= slot.roads;
+    slot.roads = 0;
+    slot.used = slot.referenced = false;
+}
+
+void RouteCache::compactPostings(Shard& shard) {
+    shard.postings.clear();
+    shard.postingCount = 0;
+    ResultReader reader;
+    Output output;
+    for (uint32_t position = 0; position < shard.slots.size(); ++position) {
+        Slot& slot = shard.slots[position];
+        if (!slot.used) continue;
+        // Only the listed suggestions are in the record, so the entry may need fewer postings now
+        shard.liveRoads -= slot.roads;
+        std::vector<uint64_t> roads;
+        if (reader.readRecord(slot.record, output)) roads = roadsOf(output);
+        for (uint64_t road : roads) shard.postings[road].push_back(position);
+        slot.roads = static_cast<uint32_t>(roads.size());
+        shard.postingCount += roads.size();
+        shard.liveRoads += roads.size();
+    }
+}
+
+size_t RouteCache::invalidateRoad(int fromId, int toId, bool isDriving) {
+    uint64_t road = roadKey(fromId, toId);
+    size_t dropped = 0;
+    ResultReader reader;
+    Output output;
+    for (size_t s = 0; s < shardCount; ++s) {
+        Shard& shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.guard);
+        auto it = shard.postings.find(road);
+        if (it == shard.postings.end()) continue;
+        std::vector<uint32_t>& list = it->second;
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        // Keep the postings of the entries still cached that take the road in the other mode
+        size_t kept = 0;
+        for (uint32_t position : list) {
+            Slot& slot = shard.slots[position];
+            if (!slot.used || !reader.readRecord(slot.record, output)) continue;
+            if (usesRoad(output, road, isDriving)) {
+                release(shard, position);
+                ++dropped;
+            } else if (usesRoad(output, road, !isDriving)) {
+                list[kept++] = position;
+            }
+        }
+        shard.postingCount -= list.size() - kept;
+        list.resize(kept);
+        if (list.empty()) shard.postings.erase(it);
+    }
+    invalidated.fetch_add(dropped, std::memory_order_relaxed);
+    return dropped;
+}
+
+size_t RouteCache::revalidateFasterRoad(int time, bool isDriving, const Neighbourhood& nearFrom,
+                                        const Neighbourhood& nearTo) {
+    size_t dropped = 0, kept = 0;
+    for (size_t s = 0; s < shardCount; ++s) {
+        Shard& shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.guard);
+        for (uint32_t position = 0; position < shard.slots.size(); ++position) {
+            Slot& slot = shard.slots[position];
+            if (!slot.used || (!isDriving && slot.mode != 2)) continue;
+            bool affected = slot.mode == 2;
+            if (!affected) {
+                auto beaten = [&](int routeTime) {
+                    return Neighbourhood::mayBeat(nearFrom, nearTo, time, slot.sourceId, slot.destId, routeTime);
+                };
+                affected = beaten(slot.bestTime) || (slot.altTime >= 0 && beaten(slot.altTime));
+            }
+            if (affected) {
+                release(shard, position);
+                ++dropped;
+            } else {
+                ++kept;
+            }
+        }
+    }
+    invalidated.fetch_add(dropped, std::memory_order_relaxed);
+    revalidated.fetch_add(kept, std::memory_order_relaxed);
+    return dropped;
+}
+
+bool RouteCache::takesRoad(const Output& output, int fromId, int toId, bool isDriving) {
+    return usesRoad(output, roadKey(fromId, toId), isDriving);
+}
+
+RouteCache::Counters RouteCache::counters() const {
+    Counters counters;
+    counters.hits = hits.load(std::memory_order_relaxed);
+    counters.misses = misses.load(std::memory_order_relaxed);
+    counters.insertions = insertions.load(std::memory_order_relaxed);
+    counters.evictions = evictions.load(std::memory_order_relaxed);
+    counters.invalidated = invalidated.load(std::memory_order_relaxed);
+    counters.revalidated = revalidated.load(std::memory_order_relaxed);
+    return counters;
+}
+
+size_t RouteCache::size() const {
+    size_t entries = 0;
+    for (size_t s = 0; s < shardCount; ++s) {
+        std::lock_guard<std::mutex> lock(shards[s].guard);
+        entries += shards[s].index.size();
+    }
+    return entries;
+}
+
+void RouteCache::writeText(std::ostream& out) const {
+    Counters c = counters();
+    uint64_t lookups = c.hits + c.misses;
+    std::ios::fmtflags flags = out.flags();
+    out << "Route cache: " << lookups << " lookups, " << std::fixed << std::setprecision(1)
+        << (lookups ? 100.0 * double(c.hits) / double(lookups) : 0.0) << "% hits (" << c.hits << " hits, "
+        << c.misses << " misses), " << c.insertions << " insertions, " << c.evictions << " evictions, "
+        << c.invalidated << " invalidated and " << c.revalidated << " revalidated by road updates, "
+        << size() << " of " << capacity() << " entries" << std::endl;
+    out.flags(flags);
+}
+
+void RouteCache::reportMemory(MemoryReport& report) const {
+    size_t slots = 0, records = 0, index = 0, postings = 0;
+    for (size_t s = 0; s < shardCount; ++s) {
+        std::lock_guard<std::mutex> lock(shards[s].guard);
+        slots += MemoryReport::vectorBytes(shards[s].slots);
+        for (const Slot& slot : shards[s].slots) records += MemoryReport::stringBytes(slot.record);
+        index += MemoryReport::hashTableBytes(shards[s].index);
+        postings += MemoryReport::hashTableBytes(shards[s].postings);
+        for (const auto& [road, list] : shards[s].postings) postings += MemoryReport::vectorBytes(list);
+    }
+    report.add("cache", "slots", MemoryReport::allocation(shardCount * sizeof(Shard)) + slots);
+    report.add("cache", "records", records);
+    report.add("cache", "key index", index);
+    report.add("cache", "road index", postings);
+}
@@ -0,0 +1,179 @@
+/**
+* @file RouteCache.h
+ * @brief Sharded CLOCK cache of planner results keyed by query fingerprint, invalidated road by road
+ */
+
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include "FileManager.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MemoryReport;
+
+/**
+ * @class RouteCache
+ * @brief Remembers the Output of recent queries so repeated ones skip the planners
+ * @details Entries are keyed by fingerprint(), a 64-bit hash of everything that
+ * determines the answer; two different queries sharing a fingerprint is assumed not to
+ * happen. Each entry holds the result as a binary result record (delta-coded paths and
+ * times, see BinaryResultHeader).
+ *
+ * The key space is split into shards, each with its own lock, slots and CLOCK hand:
+ * a hit sets the slot's reference bit and a miss that needs room sweeps the hand,
+ * clearing bits until it finds an unreferenced slot to replace. Lookups and inserts
+ * may come from any number of threads.
+ *
+ * Each shard also keeps an inverted index from every road to the slots whose routes
+ * take it, as posting lists of slot numbers, so a road update only touches the entries
+ * it can change. Postings of replaced entries are left behind and skipped, as every
+ * entry is checked against its record; the lists are rebuilt when they hold more
+ * stale postings than live ones.
+ */
+class RouteCache {
+public:
+    /**
+     * @struct Counters
+     * @brief Lookup outcomes since the cache was created
+     */
+    struct Counters {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidated = 0;   ///< Entries dropped by road updates
+        uint64_t revalidated = 0;   ///< Entries kept after a check against a faster road
+    };
+
+    /**
+     * @param capacity Maximum number of entries, split evenly over the shards.
+     * @param shards Number of independently locked shards.
+     */
+    explicit RouteCache(size_t capacity, size_t shards = 16);
+
+    /**
+     * @brief Hashes the mode, IDs, walking limit, include node and avoid sets of a query.
+     * @details The avoid sets are combined without regard to order.
+     * @complexity O(A) where A is the number of avoided items.
+     */
+    static uint64_t fingerprint(const Input& input);
+
+    /**
+     * @brief Finds the result of a query.
+     * @return True on a hit, with output filled and its search statistics zeroed.
+     */
+    bool lookup(uint64_t key, Output& output);
+
+    /**
+     * @brief Stores the result of a query, replacing any entry with the same key.
+     * @complexity O(R log R) where R is the number of roads on its routes.
+     */
+    void insert(uint64_t key, const Output& output);
+
+    /**
+     * @brief Drops the entries whose routes take a road that closed or became slower.
+     * @details Routes not taking the road are still the fastest, as no other route got
+     * faster. Only the routes of the mode whose time changed are checked.
+     * @return The number of entries dropped.
+     * @complexity O(P R) where P is the number of postings of the road and R the roads per entry.
+     */
+    size_t invalidateRoad(int fromId, int toId, bool isDriving);
+
+    /**
+     * @brief Drops the entries a road that opened or became faster may improve.
+     * @details A route can only be beaten through the road, so entries whose routes are all
+     * faster than Neighbourhood::mayBeat() allows are kept. Driving-walking
+     * entries depend on every parking location and are dropped; driving entries are kept
+     * when only the walking time changed.
+     * @param time The road's new time.
+     * @param nearFrom, nearTo Driving distances around the road's ends after the update;
+     * unused for a walking time.
+     * @return The number of entries dropped.
+     * @complexity O(E) where E is the number of entries.
+     */
+    size_t revalidateFasterRoad(int time, bool isDriving, const Neighbourhood& nearFrom, const Neighbourhood& nearTo);
+
+    /**
+     * @brief Check if a path of a result travelled in the given mode takes the road between two locations.
+     * @complexity O(N) where N is the total length of the paths.
+     */
+    static bool takesRoad(const Output& output, int fromId, int toId, bool isDriving);
+
+    Counters counters() const;
+    size_t size() const;
+    size_t capacity() const { return shardCount * slotsPerShard; }
+
+    /**
+     * @brief Writes the hit rate and the other counters on one line.
+     */
+    void writeText(std::ostream& out) const;
+
+    /**
+     * @brief Adds the slots, records, key tables and road index to a memory report.
+     */
+    void reportMemory(MemoryReport& report) const;
+
+private:
+    /**
+     * @struct Slot
+     * @brief One cached result
+     */
+    struct Slot {
+        uint64_t key = 0;
+        std::string record;      ///< Binary result record
+        int8_t mode = 0;         ///< TypeOfInput of the result
+        int sourceId = 0;
+        int destId = 0;
+        int bestTime = INF;      ///< INF if no route was found
+        int altTime = -1;        ///< INF if no alternative was found, -1 if none was searched for
+        uint32_t roads = 0;      ///< Postings added for the entry
+        bool used = false;
+        bool referenced = false; ///< CLOCK bit, set by hits
+    };
+
+    /**
+     * @struct Shard
+     * @brief Independently locked part of the cache
+     */
+    struct Shard {
+        mutable std::mutex guard;
+        std::vector<Slot> slots;
+        std::unordered_map<uint64_t, uint32_t> index;   ///< Key -> slot
+        std::unordered_map<uint64_t, std::vector<uint32_t>> postings;  ///< Road -> slots whose routes may take it
+        size_t postingCount = 0;                        ///< Postings in all lists
+        size_t liveRoads = 0;                           ///< Postings added for the entries still cached
+        uint32_t hand = 0;                              ///< Next slot the CLOCK sweep looks at
+    };
+
+    Shard& shardOf(uint64_t key) { return shards[(key >> 48) % shardCount]; }
+
+    /**
+     * @brief Empties a slot and removes it from the key index; its postings go stale.
+     */
+    static void release(Shard& shard, uint32_t position);
+
+    /**
+     * @brief Rebuilds the posting lists of a shard from its cached entries.
+     */
+    static void compactPostings(Shard& shard);
+
+    size_t shardCount;
+    size_t slotsPerShard;
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> insertions{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> invalidated{0};
+    std::atomic<uint64_t> revalidated{0};
+};
+
+#endif // ROUTE_CACHE_H
@@ -0,0 +1,125 @@
+#include "RoutePlanner.h"
+#include "Trace.h"
+#include <iostream>
+using namespace std;
+
+namespace {
+
+/**
+ * @class StatsScope
+ * @brief Collects the search statistics of one query into its Output
+ */
+class StatsScope {
+public:
+    explicit StatsScope(Output& output) : output(output) { SearchStats::local() = SearchStats(); }
+    ~StatsScope() { output.stats = SearchStats::local(); }
+
+private:
+    Output& output;
+};
+
+} // namespace
+
+bool RoutePlanner::solveNormalRoute(SearchEngine& engine, Input& input, Output& output) {
+    TraceSpan span("solveNormalRoute", "source", input.sourceId, "destination", input.destId);
+    StatsScope stats(output);
+    output.sourceId = input.sourceId;
+    output.destId = input.destId;
+    output.TypeOfInput = 0;
+    if (input.sourceId == -1 || input.destId == -1) {
+        cerr << "Error: Invalid input file format.\n";
+        return false;
+    }
+    if (!engine.hasLocation(input.sourceId) || !engine.hasLocation(input.destId)) {
+        cerr << "Error: Invalid Source or Destination ID.\n";
+        return false;
+    }
+    output.bestPath = engine.findPath(input.sourceId, input.destId, true, input.avoidNodes,input.avoidSegments);
+    if (output.bestPath.first.size() > 1) {
+        output.altPath = engine.findPath(input.sourceId, input.destId, true, input.avoidNodes, input.avoidSegments);
+    }
+    return true;
+}
+
+bool RoutePlanner::solveRestrictedRoute(SearchEngine& engine, Input& input, Output& output) {
+    TraceSpan span("solveRestrictedRoute", "source", input.sourceId, "destination", input.destId);
+    StatsScope stats(output);
+    output.TypeOfInput = 1;
+    output.sourceId = input.sourceId;
+    output.destId = input.destId;
+    if (input.sourceId == -1 || input.destId == -1) {
+        cerr << "Error: Invalid input file format.\n";
+        return false;
+    }
+    if (!engine.hasLocation(input.sourceId) || !engine.hasLocation(input.destId)) {
+        cerr << "Error: Invalid Source or Destination ID.\n";
+        return false;
+    }
+
+    if (input.includeNodeId != -1) {
+        auto firstHalf = engine.findPath(input.sourceId, input.includeNodeId, true, input.avoidNodes, input.avoidSegments);
+        if (firstHalf.first.empty()) return true;
+
+        auto secondHalf = engine.findPath(input.includeNodeId, input.destId, true, input.avoidNodes, input.avoidSegments);
+        if (secondHalf.first.empty()) return true;
+
+        // Merge paths (remove duplicate includeNodeId)
+        std::vector<int> fullPath = firstHalf.first;
+        fullPath.pop_back(); // remove includeNode from the first half
+        fullPath.insert(fullPath.end(), secondHalf.first.begin(), secondHalf.first.end());
+        output.bestPath.first = fullPath;
+        output.bestPath.second = firstHalf.second + secondHalf.second; //Sum of times
+    }
+    else {
+        output.bestPath = engine.findPath(input.sourceId, input.destId, true, input.avoidNodes, input.avoidSegments);
+    }
+    return true;
+}
+
+bool RoutePlanner::solveEnvironmentallyFriendlyRoute(SearchEngine& engine, Input& input, Output& output) {
+    TraceSpan span("solveEnvironmentallyFriendlyRoute", "source", input.sourceId, "destination", input.destId);
+    StatsScope stats(output);
+    output.TypeOfInput = 2;
+    output.sourceId = input.sourceId;
+    output.destId = input.destId;
+    output.maxWalkingTime = input.maxWalkingTime;
+
+    if (input.sourceId == -1 || input.destId == -1 || input.maxWalkingTime == -1) {
+        cerr << "Error: Invalid environmentally-friendly input file format.\n";
+        return false;
+    }
+
+    auto [drivePath, walkPath, parkingNode, totalTime, walkingTime, suggestions] = engine.environmentallyFriendlyRoute(
+        input.sourceId, input.destId, input.maxWalkingTime, input.avoidNodes, input.avoidSegments);
+    if (!drivePath.empty() && !walkPath.empty() && parkingNode != -1) {
+        output.bestPath.first = drivePath;
+        output.altPath.first = walkPath;
+        output.bestPath.second = totalTime - walkingTime;
+        output.altPath.second = walkingTime;
+        output.parkingNode = parkingNode;
+        output.totalTime = totalTime;
+
+    } else if(!suggestions.empty()){
+        output.bestPath.first = suggestions[0].drivePath;
+        output.altPath.first = suggestions[0].walkPath;
+        output.bestPath.second = suggestions[0].totalTime - suggestions[0].walkingTime;
+        output.altPath.second = suggestions[0].walkingTime;
+        output.parkingNode = suggestions[0].parkingNode;
+        output.totalTime = suggestions[0].totalTime;
+        output.hasSuggestions = true;
+        output.suggestions = suggestions;
+
+    }   else{
+        cerr << "No feasible environmentally-friendly route found.\n";
+        return false;
+    }
+    return true;
+}
+
+bool RoutePlanner::solve(SearchEngine& engine, Input& input, Output& output) {
+    switch (input.TypeOfInput) {
+        case 0: return solveNormalRoute(engine, input, output);
+        case 1: return solveRestrictedRoute(engine, input, output);
+        default: return solveEnvironmentallyFriendlyRoute(engine, input, output);
+    }
+}
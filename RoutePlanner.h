@@ -0,0 +1,50 @@
+/**
+* @file RoutePlanner.h
+ * @brief Turns route planning queries into results using a search engine
+ */
+
+#ifndef ROUTE_PLANNER_H
+#define ROUTE_PLANNER_H
+
+#include "FileManager.h"
+#include "SearchEngine.h"
+
+/**
+ * @class RoutePlanner
+ * @brief Computes the Output of each planning mode from an Input
+ * @details Shared by the interactive menu, batch mode, the JSON server and the benchmark.
+ * Problems are reported on cerr and the search statistics of each query are stored in
+ * Output::stats. The avoided segments of the input grow with the
+ * segments of the routes found, which is how alternative routes are obtained.
+ */
+class RoutePlanner {
+public:
+    /**
+     * @brief Computes the best and alternative driving routes.
+     * @return False if the query is invalid.
+     * @complexity O((N + M) log N) where N is the number of locations and M is the number of roads.
+     */
+    static bool solveNormalRoute(SearchEngine& engine, Input& input, Output& output);
+
+    /**
+     * @brief Computes the restricted driving route, passing through the included location if any.
+     * @return False if the query is invalid.
+     * @complexity O((N + M) log N) where N is the number of locations and M is the number of roads.
+     */
+    static bool solveRestrictedRoute(SearchEngine& engine, Input& input, Output& output);
+
+    /**
+     * @brief Computes the environmentally friendly route, or the closest suggestions.
+     * @return False if the query is invalid or no route exists.
+     * @complexity O(P (N + M) log N) where P is the number of parking locations.
+     */
+    static bool solveEnvironmentallyFriendlyRoute(SearchEngine& engine, Input& input, Output& output);
+
+    /**
+     * @brief Computes the answer to a query of any mode.
+     * @return False if the query is invalid or has no answer; the reason is printed on cerr.
+     */
+    static bool solve(SearchEngine& engine, Input& input, Output& output);
+};
+
+#endif // ROUTE_PLANNER_H
@@ -0,0 +1,169 @@
+#include "RouteSubscriptions.h"
+#include "ResultWriter.h"
+#include "RouteCache.h"
+#include "RoutePlanner.h"
+#include "SearchEngine.h"
+#include <algorithm>
+
+RouteSubscriptions::RouteSubscriptions(Publish publish)
+    : publish(std::move(publish)), worker(&RouteSubscriptions::run, this) {}
+
+RouteSubscriptions::~RouteSubscriptions() {
+    finish();
+}
+
+void RouteSubscriptions::finish() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(guard);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+uint64_t RouteSubscriptions::subscribe(const Input& input, Network current, uint64_t version) {
+    std::lock_guard<std::mutex> lock(guard);
+    uint64_t number = nextNumber++;
+    Subscription& subscription = subscriptions[number];
+    subscription.input = input;
+    // Counted as queued, so road updates leave it alone until activate() queues it
+    subscription.queued = true;
+    if (!network || version >= networkVersion) {
+        network = std::move(current);
+        networkVersion = version;
+    }
+    ++totals.subscribed;
+    return number;
+}
+
+void RouteSubscriptions::activate(uint64_t subscription) {
+    std::lock_guard<std::mutex> lock(guard);
+    if (!subscriptions.count(subscription)) return;
+    pending.push_back(subscription);
+    wake.notify_one();
+}
+
+bool RouteSubscriptions::unsubscribe(uint64_t subscription) {
+    std::lock_guard<std::mutex> lock(guard);
+    // A queued number left in pending is skipped by the worker
+    return subscriptions.erase(subscription) > 0;
+}
+
+bool RouteSubscriptions::affected(const Subscription& subscription, const RoadChange& change) {
+    const Output& result = subscription.result;
+    if (change.newTime > change.oldTime) {
+        return subscription.found && RouteCache::takesRoad(result, change.fromId, change.toId, change.isDriving);
+    }
+    if (subscription.input.TypeOfInput == 2) return true;
+    if (!change.isDriving) return false;
+    auto beaten = [&](const std::pair<std::vector<int>, int>& route) {
+        int time = subscription.found && !route.first.empty() ? route.second : INF;
+        return Neighbourhood::mayBeat(change.nearFrom, change.nearTo, change.newTime,
+                                      subscription.input.sourceId, subscription.input.destId, time);
+    };
+    // The alternative route is only searched for when the best one has intermediate locations
+    bool hasAlternative = subscription.found && result.TypeOfInput == 0 && result.bestPath.first.size() > 1;
+    return beaten(result.bestPath) || (hasAlternative && beaten(result.altPath));
+}
+
+size_t RouteSubscriptions::roadUpdated(uint64_t version, const std::vector<RoadChange>& changes,
+                                       const std::function<Network()>& updated) {
+    std::lock_guard<std::mutex> lock(guard);
+    ++totals.updates;
+    size_t queued = 0;
+    for (auto& [number, subscription] : subscriptions) {
+        if (subscription.queued) continue;
+        // A result still being computed is for an older network, so it is recomputed on this one
+        bool stale = !subscription.computed || subscription.validAt + 1 != version;
+        bool changed = stale;
+        for (size_t i = 0; i < changes.size() && !changed; ++i) changed = affected(subscription, changes[i]);
+        if (!changed) {
+            subscription.validAt = version;
+            continue;
+        }
+        subscription.queued = true;
+        pending.push_back(number);
+        ++queued;
+    }
+    // The network is built under the lock, so the worker never takes the queue with an older one
+    if (!pending.empty()) {
+        network = updated();
+        networkVersion = version;
+        wake.notify_one();
+    }
+    return queued;
+}
+
+void RouteSubscriptions::run() {
+    std::unique_ptr<SnapshotEngine> engine;
+    Network engineNetwork;   // Kept alive while the engine searches it
+    std::vector<uint64_t> batch;
+    std::vector<std::pair<uint64_t, Input>> work;
+    std::unique_lock<std::mutex> lock(guard);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || !pending.empty(); });
+        if (pending.empty()) return;
+        batch.swap(pending);
+        pending.clear();
+        Network current = network;
+        uint64_t version = networkVersion;
+        work.clear();
+        for (uint64_t number : batch) {
+            auto it = subscriptions.find(number);
+            if (it == subscriptions.end() || !it->second.queued) continue;
+            it->second.queued = false;
+            work.emplace_back(number, it->second.input);
+        }
+        lock.unlock();
+
+        if (current != engineNetwork) {
+            engine = std::make_unique<SnapshotEngine>(*current);
+            engineNetwork = current;
+        }
+        std::vector<Output> results(work.size());
+        std::vector<char> found(work.size());
+        for (size_t i = 0; i < work.size(); ++i) {
+            // The planners extend the avoided segments, so each search gets its own copy
+            Input input = work[i].second;
+            found[i] = RoutePlanner::solve(*engine, input, results[i]);
+        }
+
+        lock.lock();
+        std::string record;
+        for (size_t i = 0; i < work.size(); ++i) {
+            auto it = subscriptions.find(work[i].first);
+            if (it == subscriptions.end()) continue;
+            Subscription& subscription = it->second;
+            ++totals.recomputed;
+            subscription.validAt = std::max(subscription.validAt, version);
+            record.clear();
+            if (found[i]) ResultWriter::encode(results[i], record);
+            if (subscription.computed && bool(found[i]) == subscription.found && record == subscription.record) continue;
+            subscription.computed = true;
+            subscription.found = found[i];
+            subscription.record.swap(record);
+            subscription.result = std::move(results[i]);
+            ++totals.published;
+            // Published under the lock, so nothing reaches a client after its unsubscribe is answered
+            publish(work[i].first, version, subscription.found ? &subscription.result : nullptr);
+        }
+    }
+}
+
+size_t RouteSubscriptions::size() const {
+    std::lock_guard<std::mutex> lock(guard);
+    return subscriptions.size();
+}
+
+RouteSubscriptions::Counters RouteSubscriptions::counters() const {
+    std::lock_guard<std::mutex> lock(guard);
+    return totals;
+}
+
+void RouteSubscriptions::writeText(std::ostream& out) const {
+    Counters c = counters();
+    out << "Route subscriptions: " << c.subscribed << " subscribed, " << size() << " active, " << c.updates
+        << " road updates checked, " << c.recomputed << " routes recomputed, " << c.published
+        << " changed results pushed" << std::endl;
+}
@@ -0,0 +1,164 @@
+/**
+* @file RouteSubscriptions.h
+ * @brief Standing route queries recomputed in the background when the roads they depend on change
+ */
+
+#ifndef ROUTE_SUBSCRIPTIONS_H
+#define ROUTE_SUBSCRIPTIONS_H
+
+#include "FileManager.h"
+#include "GraphSnapshot.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct RoadChange
+ * @brief A road's time in one mode before and after an update
+ */
+struct RoadChange {
+    int fromId = -1;
+    int toId = -1;
+    bool isDriving = true;
+    int oldTime = INF;
+    int newTime = INF;
+    Neighbourhood nearFrom;   ///< Driving distances around fromId after the update, for a faster driving time
+    Neighbourhood nearTo;     ///< Driving distances around toId after the update, for a faster driving time
+};
+
+/**
+ * @class RouteSubscriptions
+ * @brief Keeps the results of registered queries up to date as roads change
+ * @details Each subscription holds a query and its last result. After a road update only
+ * the subscriptions the change can affect are queued: those whose routes take a road that
+ * closed or got slower in that mode, and those a faster road may beat (see
+ * Neighbourhood::mayBeat(); driving-walking subscriptions depend on every parking location
+ * and are always queued). A worker thread recomputes the queued queries on the latest
+ * network with its own engine and publishes a result only when it differs from the last one.
+ *
+ * Every subscription knows the last graph version its result is known to hold at. A
+ * subscription still waiting for or being recomputed when another update comes is queued
+ * again, so results always catch up with the newest network.
+ */
+class RouteSubscriptions {
+public:
+    using Network = std::shared_ptr<const GraphSnapshot>;
+
+    /**
+     * @brief Receives a subscription's new result and the graph version it was computed at,
+     * or nullptr if the query has no route. Called on the worker thread.
+     */
+    using Publish = std::function<void(uint64_t subscription, uint64_t version, const Output* output)>;
+
+    /**
+     * @struct Counters
+     * @brief Work done since construction
+     */
+    struct Counters {
+        uint64_t subscribed = 0;
+        uint64_t updates = 0;        ///< Road updates checked against the subscriptions
+        uint64_t recomputed = 0;     ///< Queries recomputed by the worker
+        uint64_t published = 0;      ///< Recomputed results that changed and were published
+    };
+
+    /**
+     * @brief Starts the worker thread.
+     */
+    explicit RouteSubscriptions(Publish publish);
+
+    /**
+     * @brief Calls finish().
+     */
+    ~RouteSubscriptions();
+
+    RouteSubscriptions(const RouteSubscriptions&) = delete;
+    RouteSubscriptions& operator=(const RouteSubscriptions&) = delete;
+
+    /**
+     * @brief Registers a query; nothing is computed for it until activate() is called.
+     * @details This lets the caller answer the request with the subscription number
+     * before the worker can publish the first result.
+     * @param input The query as received, before the planners extend its avoided segments.
+     * @param current The current network, at graph version version.
+     * @return The subscription number.
+     */
+    uint64_t subscribe(const Input& input, Network current, uint64_t version);
+
+    /**
+     * @brief Queues a registered subscription, whose first result is then computed and published by the worker.
+     */
+    void activate(uint64_t subscription);
+
+    /**
+     * @brief Cancels a subscription. A recomputation already running is not published.
+     * @return False if there is no such subscription.
+     */
+    bool unsubscribe(uint64_t subscription);
+
+    /**
+     * @brief Queues the subscriptions affected by a road update that produced graph version version.
+     * @param changes The times the update changed, at most one per mode.
+     * @param updated Returns the updated network; only called if a subscription is queued.
+     * @return The number of subscriptions queued.
+     * @complexity O(S P) where S is the number of subscriptions and P the length of their paths.
+     */
+    size_t roadUpdated(uint64_t version, const std::vector<RoadChange>& changes,
+                       const std::function<Network()>& updated);
+
+    /**
+     * @brief Finishes the queued recomputations and stops the worker; nothing is published afterwards.
+     */
+    void finish();
+
+    size_t size() const;
+    Counters counters() const;
+
+    /**
+     * @brief Writes the subscription counts on one line.
+     */
+    void writeText(std::ostream& out) const;
+
+private:
+    /**
+     * @struct Subscription
+     * @brief One standing query and its last published result
+     */
+    struct Subscription {
+        Input input;
+        Output result;
+        std::string record;       ///< Binary result record of result, compared to detect changes
+        bool computed = false;    ///< A result was published
+        bool found = false;       ///< The last result has a route
+        bool queued = false;
+        uint64_t validAt = 0;     ///< Last graph version the result holds at, if computed
+    };
+
+    /**
+     * @brief Check if a road change can alter a subscription's result.
+     */
+    static bool affected(const Subscription& subscription, const RoadChange& change);
+
+    void run();
+
+    Publish publish;
+    mutable std::mutex guard;
+    std::condition_variable wake;
+    std::unordered_map<uint64_t, Subscription> subscriptions;
+    std::vector<uint64_t> pending;      ///< Queued subscriptions, in queuing order
+    Network network;                    ///< Latest network handed to the worker
+    uint64_t networkVersion = 0;        ///< Graph version of network
+    uint64_t nextNumber = 1;
+    bool stopping = false;
+    Counters totals;
+    std::thread worker;
+};
+
+#endif // ROUTE_SUBSCRIPTIONS_H
@@ -0,0 +1,442 @@
+#include "RouteVerifier.h"
+#include "AllPairsTable.h"
+#include "CompressedGraph.h"
+#include "GraphSnapshot.h"
+#include "LandmarkIndex.h"
+#include "RoutePlanner.h"
+#include "SearchEngine.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+using namespace std;
+
+namespace {
+
+/**
+ * @struct Random
+ * @brief splitmix64 generator, so every round only depends on the seed
+ */
+struct Random {
+    uint64_t state;
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    int below(int bound) { return static_cast<int>(next() % uint64_t(bound)); }
+    bool chance(double p) { return double(next() >> 11) * 0x1.0p-53 < p; }
+};
+
+/**
+ * @struct TestNetwork
+ * @brief A road network as plain lists, easy to generate, shrink and write out
+ */
+struct TestNetwork {
+    struct Place {
+        int id;
+        bool parking;
+    };
+    struct Link {
+        int from;
+        int to;
+        int driving;
+        int walking;
+    };
+
+    vector<Place> places;
+    vector<Link> links;   ///< Two-way roads, as in DisSample.txt
+
+    void build(Graph& graph) const {
+        for (const auto& place : places) graph.addLocation(place.id, "L" + to_string(place.id), place.parking);
+        for (const auto& link : links) {
+            graph.addRoad(graph.findLocation(link.from), graph.findLocation(link.to), link.driving, link.walking);
+        }
+    }
+};
+
+/**
+ * @struct Case
+ * @brief One query on one network with one engine
+ */
+struct Case {
+    TestNetwork network;
+    Input query;
+    string engine;
+    bool localityOrder;   ///< Snapshot node order, which changes how engines break ties
+    bool endToEnd;        ///< Compare the whole Output; only sound when shortest paths are unique
+};
+
+/**
+ * @brief Generates a random network of 2 to 40 locations.
+ * @param wide Draw weights from [1, 2^20], making equal-length paths unlikely, instead of [0, 9].
+ */
+TestNetwork randomNetwork(Random& random, bool wide) {
+    int n = 2 + random.below(39);
+    vector<int> ids(3 * size_t(n));
+    iota(ids.begin(), ids.end(), 1);
+    for (size_t i = ids.size() - 1; i > 0; --i) swap(ids[i], ids[random.below(static_cast<int>(i) + 1)]);
+
+    TestNetwork network;
+    for (int i = 0; i < n; ++i) network.places.push_back({ids[i], random.chance(0.3)});
+    auto weight = [&] {
+        if (random.chance(0.1)) return INF;
+        return wide ? 1 + random.below(1 << 20) : random.below(10);
+    };
+    auto link = [&](int a, int b) {
+        network.links.push_back({network.places[a].id, network.places[b].id, weight(), weight()});
+    };
+    // A mostly connected tree, then random extra roads, some parallel and a few loops
+    for (int i = 1; i < n; ++i) {
+        if (random.chance(0.9)) link(i, random.below(i));
+    }
+    for (int extra = random.below(2 * n + 1); extra > 0; --extra) {
+        int a = random.below(n);
+        link(a, random.chance(0.03) ? a : random.below(n));
+    }
+    return network;
+}
+
+Input randomQuery(Random& random, const TestNetwork& network, bool wide) {
+    auto randomId = [&] { return network.places[random.below(static_cast<int>(network.places.size()))].id; };
+    Input input;
+    input.TypeOfInput = random.below(3);
+    input.sourceId = randomId();
+    input.destId = randomId();
+    for (int k = random.below(3); k > 0; --k) input.avoidNodes.insert(randomId());
+    if (!network.links.empty()) {
+        for (int k = random.below(3); k > 0; --k) {
+            const auto& link = network.links[random.below(static_cast<int>(network.links.size()))];
+            if (random.chance(0.5)) input.avoidSegments.insert({link.from, link.to});
+            else input.avoidSegments.insert({link.to, link.from});
+        }
+    }
+    if (input.TypeOfInput == 1 && random.chance(0.5)) input.includeNodeId = randomId();
+    if (input.TypeOfInput == 2) input.maxWalkingTime = wide ? random.below(3 << 20) : random.below(30);
+    return input;
+}
+
+string pathText(const vector<int>& path, int time) {
+    if (path.empty()) return "none";
+    ostringstream text;
+    for (int id : path) text << id << ' ';
+    text << '(' << time << ')';
+    return text.str();
+}
+
+/**
+ * @class CheckedEngine
+ * @brief Forwards to an engine and repeats every findPath with Graph::dijkstra
+ * @details Keeps the description of the first disagreement. The multimodal planner
+ * runs through the base SearchEngine implementation, so its searches are checked too.
+ */
+class CheckedEngine : public SearchEngine {
+public:
+    CheckedEngine(SearchEngine& candidate, Graph& graph) : candidate(candidate), graph(graph) {}
+
+    const char* name() const override { return candidate.name(); }
+    bool hasLocation(int id) const override { return candidate.hasLocation(id); }
+    const vector<int>& parkingLocations() override { return candidate.parkingLocations(); }
+    void reportMemory(MemoryReport& report) const override { candidate.reportMemory(report); }
+
+    pair<vector<int>, int> findPath(int sourceId, int destinationId, bool isDriving,
+                                    const unordered_set<int>& blockedNodes,
+                                    unordered_set<pair<int, int>, pair_hash>& blockedSegments) override {
+        auto before = blockedSegments;
+        auto referenceSegments = blockedSegments;
+        auto expected = graph.dijkstra(sourceId, destinationId, isDriving, blockedNodes, referenceSegments);
+        auto result = candidate.findPath(sourceId, destinationId, isDriving, blockedNodes, blockedSegments);
+        if (failure.empty()) {
+            string problem = check(sourceId, destinationId, isDriving, blockedNodes, before, blockedSegments, result, expected);
+            if (!problem.empty()) {
+                ostringstream text;
+                text << "findPath(" << sourceId << " -> " << destinationId << ", " << (isDriving ? "driving" : "walking")
+                     << ", " << blockedNodes.size() << " avoided locations, " << before.size()
+                     << " avoided segments): " << problem;
+                failure = text.str();
+            }
+        }
+        return result;
+    }
+
+    const string& firstFailure() const { return failure; }
+
+private:
+    /**
+     * @brief Cheapest usable road from a to b, or INF.
+     */
+    int roadWeight(int a, int b, bool isDriving) const {
+        int best = INF;
+        const Location* origin = graph.findLocation(a);
+        if (!origin) return INF;
+        for (const Road* road : origin->getAdj()) {
+            if (road->getDestination()->getId() != b) continue;
+            best = min(best, isDriving ? road->getDrivingTime() : road->getWalkingTime());
+        }
+        return best;
+    }
+
+    string check(int sourceId, int destinationId, bool isDriving, const unordered_set<int>& blockedNodes,
+                 const unordered_set<pair<int, int>, pair_hash>& before,
+                 const unordered_set<pair<int, int>, pair_hash>& after,
+                 const pair<vector<int>, int>& result, const pair<vector<int>, int>& expected) const {
+        ostringstream text;
+        if (result.first.empty() != expected.first.empty() || (!result.first.empty() && result.second != expected.second)) {
+            text << "returned " << pathText(result.first, result.second) << ", reference "
+                 << pathText(expected.first, expected.second);
+            return text.str();
+        }
+        if (result.first.empty()) return after == before ? "" : "changed the avoided segments without finding a path";
+        const vector<int>& path = result.first;
+        if (path.front() != sourceId || path.back() != destinationId) return "path " + pathText(path, result.second) + " has wrong ends";
+        auto expectedAfter = before;
+        long long length = 0;
+        for (size_t i = 0; i + 1 < path.size(); ++i) {
+            if (i > 0 && blockedNodes.count(path[i])) return "path " + pathText(path, result.second) + " crosses an avoided location";
+            if (before.count({path[i], path[i + 1]})) return "path " + pathText(path, result.second) + " uses an avoided segment";
+            int weight = roadWeight(path[i], path[i + 1], isDriving);
+            if (weight == INF) return "path " + pathText(path, result.second) + " uses a missing or closed road";
+            length += weight;
+            expectedAfter.insert({path[i], path[i + 1]});
+        }
+        if (length != result.second) return "path " + pathText(path, result.second) + " has length " + to_string(length);
+        if (after != expectedAfter) return "did not add exactly the path's segments to the avoided segments";
+        return "";
+    }
+
+    SearchEngine& candidate;
+    Graph& graph;
+    string failure;
+};
+
+/**
+ * @brief Compares a planner Output with the reference planner's.
+ * @return Description of the first difference, empty if they match.
+ */
+string compareOutputs(bool answered, const Output& got, bool expectedAnswered, const Output& expected) {
+    ostringstream text;
+    if (answered != expectedAnswered) {
+        text << (answered ? "answered" : "gave no answer") << ", reference " << (expectedAnswered ? "answered" : "gave no answer");
+        return text.str();
+    }
+    if (!answered) return "";
+    auto differ = [&](const char* what, const pair<vector<int>, int>& a, const pair<vector<int>, int>& b) {
+        if (a.first == b.first && (a.first.empty() || a.second == b.second)) return false;
+        text << what << ' ' << pathText(a.first, a.second) << ", reference " << pathText(b.first, b.second);
+        return true;
+    };
+    if (differ("best path", got.bestPath, expected.bestPath) || differ("second path", got.altPath, expected.altPath)) {
+        return text.str();
+    }
+    if (got.TypeOfInput != 2) return "";
+    if (got.parkingNode != expected.parkingNode || got.totalTime != expected.totalTime || got.hasSuggestions != expected.hasSuggestions) {
+        text << "parking " << got.parkingNode << " total " << got.totalTime << (got.hasSuggestions ? " (suggestion)" : "")
+             << ", reference parking " << expected.parkingNode << " total " << expected.totalTime
+             << (expected.hasSuggestions ? " (suggestion)" : "");
+        return text.str();
+    }
+    if (got.suggestions.size() != expected.suggestions.size()) {
+        text << got.suggestions.size() << " suggestions, reference " << expected.suggestions.size();
+        return text.str();
+    }
+    for (size_t i = 0; i < got.suggestions.size(); ++i) {
+        const Suggestion& a = got.suggestions[i];
+        const Suggestion& b = expected.suggestions[i];
+        if (a.parkingNode != b.parkingNode || a.totalTime != b.totalTime || a.walkingTime != b.walkingTime) {
+            text << "suggestion " << i + 1 << ": parking " << a.parkingNode << " total " << a.totalTime
+                 << ", reference parking " << b.parkingNode << " total " << b.totalTime;
+            return text.str();
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief Plans the query of a case with its engine and checks the result.
+ * @return Description of the first mismatch, empty if the engine agrees with the reference.
+ */
+string checkCase(const Case& c) {
+    Graph graph;
+    c.network.build(graph);
+    GraphSnapshot snapshot = GraphSnapshot::fromGraph(graph, c.localityOrder);
+    LandmarkIndex landmarks;
+    CompressedGraph compressed;
+    AllPairsTable allPairs;
+    unique_ptr<SearchEngine> engine;
+    if (c.engine == "reference") engine = make_unique<ReferenceEngine>(graph);
+    else if (c.engine == "snapshot") engine = make_unique<SnapshotEngine>(snapshot);
+    else if (c.engine == "alt") {
+        landmarks = LandmarkIndex::build(snapshot, 4);
+        engine = make_unique<SnapshotEngine>(snapshot, &landmarks);
+    } else if (c.engine == "all-pairs") {
+        allPairs = AllPairsTable::build(snapshot, 1);
+        engine = make_unique<AllPairsEngine>(make_unique<SnapshotEngine>(snapshot), snapshot, allPairs);
+    } else {
+        compressed = CompressedGraph::build(snapshot);
+        engine = make_unique<CompressedEngine>(compressed);
+    }
+
+    CheckedEngine checked(*engine, graph);
+    Input input = c.query;
+    Output output;
+    RoutePlanner::solve(checked, input, output);
+    if (!checked.firstFailure().empty() || !c.endToEnd) return checked.firstFailure();
+
+    Input candidateInput = c.query, referenceInput = c.query;
+    Output got, expected;
+    bool answered = RoutePlanner::solve(*engine, candidateInput, got);
+    ReferenceEngine reference(graph);
+    bool expectedAnswered = RoutePlanner::solve(reference, referenceInput, expected);
+    string problem = compareOutputs(answered, got, expectedAnswered, expected);
+    return problem.empty() ? "" : "planner output: " + problem;
+}
+
+/**
+ * @brief Shrinks a failing case while it keeps failing.
+ * @param failure Updated to the mismatch of the returned case.
+ */
+Case minimize(Case c, string& failure) {
+    auto fails = [&](const Case& candidate) {
+        string problem = checkCase(candidate);
+        if (problem.empty()) return false;
+        failure = problem;
+        return true;
+    };
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int node : vector<int>(c.query.avoidNodes.begin(), c.query.avoidNodes.end())) {
+            Case smaller = c;
+            smaller.query.avoidNodes.erase(node);
+            if (fails(smaller)) c = std::move(smaller), progress = true;
+        }
+        for (auto segment : vector<pair<int, int>>(c.query.avoidSegments.begin(), c.query.avoidSegments.end())) {
+            Case smaller = c;
+            smaller.query.avoidSegments.erase(segment);
+            if (fails(smaller)) c = std::move(smaller), progress = true;
+        }
+        if (c.query.includeNodeId != -1) {
+            Case smaller = c;
+            smaller.query.includeNodeId = -1;
+            if (fails(smaller)) c = std::move(smaller), progress = true;
+        }
+        for (size_t i = 0; i < c.network.places.size();) {
+            int id = c.network.places[i].id;
+            if (id == c.query.sourceId || id == c.query.destId || id == c.query.includeNodeId) {
+                ++i;
+                continue;
+            }
+            Case smaller = c;
+            smaller.network.places.erase(smaller.network.places.begin() + static_cast<ptrdiff_t>(i));
+            auto& links = smaller.network.links;
+            links.erase(remove_if(links.begin(), links.end(), [&](const TestNetwork::Link& link) {
+                return link.from == id || link.to == id;
+            }), links.end());
+            smaller.query.avoidNodes.erase(id);
+            if (fails(smaller)) c = std::move(smaller), progress = true;
+            else ++i;
+        }
+        for (size_t i = 0; i < c.network.links.size();) {
+            Case smaller = c;
+            smaller.network.links.erase(smaller.network.links.begin() + static_cast<ptrdiff_t>(i));
+            if (fails(smaller)) c = std::move(smaller), progress = true;
+            else ++i;
+        }
+        for (auto& place : c.network.places) {
+            if (!place.parking) continue;
+            place.parking = false;
+            if (fails(c)) progress = true;
+            else place.parking = true;
+        }
+    }
+    return c;
+}
+
+/**
+ * @brief Writes a case as LocSample/DisSample files and a one-query batch file.
+ * @return True if every file was written.
+ */
+bool writeReproducer(const Case& c, const string& prefix) {
+    ofstream locations(prefix + "LocSample.txt"), distances(prefix + "DisSample.txt"), queries(prefix + "queries.csv");
+    locations << "Location,Id,Code,Parking\n";
+    for (const auto& place : c.network.places) {
+        locations << "Place" << place.id << ',' << place.id << ",L" << place.id << ',' << (place.parking ? 1 : 0) << '\n';
+    }
+    distances << "Location1,Location2,Driving,Walking\n";
+    for (const auto& link : c.network.links) {
+        distances << 'L' << link.from << ",L" << link.to << ',';
+        if (link.driving == INF) distances << 'X';
+        else distances << link.driving;
+        distances << ',' << link.walking << '\n';
+    }
+    const Input& q = c.query;
+    static const char* const MODES[] = {"driving", "restricted", "driving-walking"};
+    queries << "Mode,Source,Destination,MaxWalkingTime,IncludeNode,AvoidNodes,AvoidSegments\n"
+            << MODES[q.TypeOfInput] << ',' << q.sourceId << ',' << q.destId << ',';
+    if (q.TypeOfInput == 2) queries << q.maxWalkingTime;
+    queries << ',';
+    if (q.includeNodeId != -1) queries << q.includeNodeId;
+    queries << ',';
+    const char* separator = "";
+    for (int node : q.avoidNodes) queries << separator << node, separator = ";";
+    queries << ',';
+    separator = "";
+    for (const auto& [from, to] : q.avoidSegments) queries << separator << from << '-' << to, separator = ";";
+    queries << '\n';
+    return locations.good() && distances.good() && queries.good();
+}
+
+} // namespace
+
+bool RouteVerifier::run(const VerifyOptions& options, ostream& out) {
+    for (const string& engine : options.engines) {
+        if (engine != "reference" && engine != "snapshot" && engine != "alt" && engine != "compressed"
+            && engine != "all-pairs") {
+            out << "Error: Unknown engine " << engine << endl;
+            return false;
+        }
+    }
+    // The planners report unanswerable queries on cerr
+    streambuf* errors = cerr.rdbuf(nullptr);
+    Random random{options.seed * 0x2545f4914f6cdd1dULL + 7};
+    size_t cases = 0;
+    for (uint32_t round = 0; round < options.rounds; ++round) {
+        bool wide = round % 2 == 1;
+        TestNetwork network = randomNetwork(random, wide);
+        bool localityOrder = random.chance(0.5);
+        for (uint32_t q = 0; q < options.queriesPerRound; ++q) {
+            Input query = randomQuery(random, network, wide);
+            for (const string& engine : options.engines) {
+                Case c{network, query, engine, localityOrder, wide};
+                string failure = checkCase(c);
+                ++cases;
+                if (failure.empty()) continue;
+
+                out << "Mismatch in round " << round + 1 << ", engine " << engine << ": " << failure << endl;
+                Case small = minimize(c, failure);
+                cerr.clear();
+                cerr.rdbuf(errors);
+                out << "Minimized to " << small.network.places.size() << " locations and " << small.network.links.size()
+                    << " roads: " << failure << endl;
+                if (writeReproducer(small, options.reproPrefix)) {
+                    out << "Reproducer: " << options.reproPrefix << "LocSample.txt, " << options.reproPrefix
+                        << "DisSample.txt and " << options.reproPrefix << "queries.csv ("
+                        << (small.localityOrder ? "locality-ordered " : "") << "snapshot, engine " << engine << ")" << endl;
+                } else {
+                    out << "Error: Unable to write the reproducer files" << endl;
+                }
+                return false;
+            }
+        }
+    }
+    cerr.clear();
+    cerr.rdbuf(errors);
+    out << "Verified " << cases << " cases on " << options.rounds << " random networks: every engine agrees with the reference"
+        << endl;
+    return true;
+}
@@ -0,0 +1,56 @@
+/**
+* @file RouteVerifier.h
+ * @brief Differential check of every search engine against the reference Graph searches
+ */
+
+#ifndef ROUTE_VERIFIER_H
+#define ROUTE_VERIFIER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @struct VerifyOptions
+ * @brief Settings of a verification run
+ */
+struct VerifyOptions {
+    uint64_t seed = 1;
+    uint32_t rounds = 100;                 ///< Random networks generated
+    uint32_t queriesPerRound = 25;         ///< Random queries answered on each network
+    std::vector<std::string> engines = {"snapshot", "alt", "compressed", "all-pairs"};
+    std::string reproPrefix = "verify_";   ///< Prefix of the reproducer files
+};
+
+/**
+ * @class RouteVerifier
+ * @brief Runs random queries on random networks with every engine and the reference
+ * @details Each round builds a small random network: random location IDs, parking,
+ * parallel roads, roads that cannot be driven or walked. Random normal, restricted and
+ * multimodal queries with random avoid sets are then planned with every engine.
+ *
+ * Two checks are made:
+ * - Every findPath call made by the planners is repeated with Graph::dijkstra on
+ *   identical inputs. The distances must match, and the returned path must be a
+ *   valid route of that length that respects the avoid sets. This holds whatever
+ *   way an engine breaks ties between equally short paths.
+ * - In rounds whose weights are drawn from a wide range, shortest paths are unique.
+ *   There the whole Output must equal the reference planner's Output. For
+ *   multimodal queries the reference is the brute-force
+ *   Graph::EnvironmentallyFriendlyRoute.
+ *
+ * The first mismatch is shrunk by repeatedly dropping avoided items, locations and
+ * roads while it persists. It is then written out as LocSample/DisSample files and a
+ * one-query batch file.
+ */
+class RouteVerifier {
+public:
+    /**
+     * @brief Runs the verification, printing progress and any mismatch on out.
+     * @return True if every engine agreed with the reference.
+     */
+    static bool run(const VerifyOptions& options, std::ostream& out);
+};
+
+#endif // ROUTE_VERIFIER_H
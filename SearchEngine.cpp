@@ -0,0 +1,113 @@
+#include "SearchEngine.h"
+#include "SearchStats.h"
+#include <algorithm>
+
+std::tuple<std::vector<int>, std::vector<int>, int, int, int, std::vector<Suggestion>>
+SearchEngine::environmentallyFriendlyRoute(
+    const int sourceId, const int destId, const int maxWalkingTime,
+    const std::unordered_set<int>& avoidNodes,
+    std::unordered_set<std::pair<int, int>, pair_hash>& avoidSegments) {
+
+    int bestTotalTime = INF, bestWalkingTime = INF;
+    std::vector<int> bestDrive, bestWalk;
+    int bestParking = -1;
+    std::vector<Suggestion> suggestions;
+
+    for (int parkingId : parkingLocations()) {
+        if (parkingId == sourceId || parkingId == destId) continue;
+        SEARCH_STAT(parkingCandidates);
+
+        auto tmpSegments = avoidSegments;
+        auto driveResult = findPath(sourceId, parkingId, true, avoidNodes, tmpSegments);
+        if (driveResult.first.empty()) continue;
+        auto walkResult = findPath(parkingId, destId, false, avoidNodes, tmpSegments);
+        if (walkResult.first.empty()) continue;
+
+        int totalTime = driveResult.second + walkResult.second;
+        int exceedWalk = std::max(0, walkResult.second - maxWalkingTime);
+        if (exceedWalk == 0) {
+            if (totalTime < bestTotalTime || (totalTime == bestTotalTime && walkResult.second < bestWalkingTime)) {
+                bestTotalTime = totalTime;
+                bestDrive = driveResult.first;
+                bestWalk = walkResult.first;
+                bestWalkingTime = walkResult.second;
+                bestParking = parkingId;
+            }
+        } else {
+            suggestions.push_back({driveResult.first, walkResult.first, parkingId, totalTime,
+                                   walkResult.second, exceedWalk});
+        }
+    }
+
+    std::sort(suggestions.begin(), suggestions.end(), [](const Suggestion& a, const Suggestion& b) {
+        return a.totalTime < b.totalTime;
+    });
+    return {bestDrive, bestWalk, bestParking, bestTotalTime, bestWalkingTime, suggestions};
+}
+
+std::pair<std::vector<int>, int> ReferenceEngine::findPath(
+    int sourceId, int destinationId, bool isDriving,
+    const std::unordered_set<int>& blockedNodes,
+    std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) {
+    if (!graph.findLocation(sourceId) || !graph.findLocation(destinationId)) return {};
+    return graph.dijkstra(sourceId, destinationId, isDriving, blockedNodes, blockedSegments);
+}
+
+const std::vector<int>& ReferenceEngine::parkingLocations() {
+    if (parking.empty()) {
+        for (const auto* location : graph.getLocations()) {
+            if (location->HasParking()) parking.push_back(location->getId());
+        }
+    }
+    return parking;
+}
+
+std::tuple<std::vector<int>, std::vector<int>, int, int, int, std::vector<Suggestion>>
+ReferenceEngine::environmentallyFriendlyRoute(
+    int sourceId, int destId, int maxWalkingTime,
+    const std::unordered_set<int>& avoidNodes,
+    std::unordered_set<std::pair<int, int>, pair_hash>& avoidSegments) {
+    return graph.EnvironmentallyFriendlyRoute(sourceId, destId, maxWalkingTime, avoidNodes, avoidSegments);
+}
+
+std::pair<std::vector<int>, int> SnapshotEngine::findPath(
+    int sourceId, int destinationId, bool isDriving,
+    const std::unordered_set<int>& blockedNodes,
+    std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) {
+    if (!landmarks) return search.run(sourceId, destinationId, isDriving, blockedNodes, blockedSegments);
+    int destination = snapshot.indexOf(destinationId);
+    if (destination < 0) return {};
+    auto target = static_cast<uint32_t>(destination);
+    return search.run(sourceId, destinationId, isDriving, blockedNodes, blockedSegments,
+                      [&](uint32_t node) { return landmarks->lowerBound(isDriving, node, target); });
+}
+
+const std::vector<int>& SnapshotEngine::parkingLocations() {
+    if (parking.empty()) {
+        for (uint32_t node = 0; node < snapshot.nodeCount(); ++node) {
+            if (snapshot.hasParking(node)) parking.push_back(snapshot.nodeId(node));
+        }
+    }
+    return parking;
+}
+
+std::pair<std::vector<int>, int> CompressedEngine::findPath(
+    int sourceId, int destinationId, bool isDriving,
+    const std::unordered_set<int>& blockedNodes,
+    std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) {
+    return search.run(sourceId, destinationId, isDriving, blockedNodes, blockedSegments);
+}
+
+void ReferenceEngine::reportMemory(MemoryReport& report) const {
+    // The search state lives in the Location objects, already counted with the graph
+    report.add(name(), "parking list", MemoryReport::vectorBytes(parking));
+}
+
+void SnapshotEngine::reportMemory(MemoryReport& report) const {
+    report.add(name(), "search workspace", search.workspaceBytes());
+    report.add(name(), "parking list", MemoryReport::vectorBytes(parking));
+}
+
+void CompressedEngine::reportMemory(MemoryReport& report) const {
+    report.add(name(), "search workspace", search.workspaceBytes());
+}
@@ -0,0 +1,151 @@
+/**
+* @file SearchEngine.h
+ * @brief Interchangeable point-to-point route search engines
+ */
+
+#ifndef SEARCH_ENGINE_H
+#define SEARCH_ENGINE_H
+
+#include "ArraySearch.h"
+#include "CompressedGraph.h"
+#include "Graph.h"
+#include "GraphSnapshot.h"
+#include "LandmarkIndex.h"
+
+#include <tuple>
+
+/**
+ * @class SearchEngine
+ * @brief Common interface of the shortest-path engines
+ * @details Every engine has the contract of Graph::dijkstra: it returns the path and its
+ * time (empty if unreachable) and adds the segments of the path to blockedSegments.
+ * Engines keep per-query workspaces, so one instance must not be shared between threads.
+ */
+class SearchEngine {
+public:
+    virtual ~SearchEngine() = default;
+
+    /**
+     * @brief Short engine name used in reports.
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Finds the fastest route between two locations.
+     * @param sourceId The starting location ID.
+     * @param destinationId The destination location ID.
+     * @param isDriving Determines if its walking or driving
+     * @param blockedNodes The locations to avoid.
+     * @param blockedSegments The roads to avoid; the segments of the returned path are added.
+     * @return The location IDs of the path and its total time, or an empty pair if unreachable.
+     */
+    virtual std::pair<std::vector<int>, int> findPath(
+        int sourceId, int destinationId, bool isDriving,
+        const std::unordered_set<int>& blockedNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) = 0;
+
+    /**
+     * @brief Check if the engine's network has a location.
+     */
+    virtual bool hasLocation(int id) const = 0;
+
+    /**
+     * @brief IDs of the locations with parking, in location order.
+     */
+    virtual const std::vector<int>& parkingLocations() = 0;
+
+    /**
+     * @brief Adds the engine's own lists and search workspace to a memory report.
+     * @details The network searched is reported by its owner.
+     */
+    virtual void reportMemory(MemoryReport& report) const = 0;
+
+    /**
+     * @brief Finds the best environmentally-friendly route combining driving and walking.
+     * @details Same contract and candidate order as Graph::EnvironmentallyFriendlyRoute,
+     * with each leg answered by findPath().
+     * @complexity O(P (N + M) log N) where P is the number of parking locations.
+     */
+    virtual std::tuple<std::vector<int>, std::vector<int>, int, int, int, std::vector<Suggestion>> environmentallyFriendlyRoute(
+        int sourceId, int destId, int maxWalkingTime,
+        const std::unordered_set<int>& avoidNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& avoidSegments);
+};
+
+/**
+ * @class ReferenceEngine
+ * @brief Graph::dijkstra on the pointer-based graph
+ */
+class ReferenceEngine : public SearchEngine {
+public:
+    explicit ReferenceEngine(Graph& graph) : graph(graph) {}
+    const char* name() const override { return "reference"; }
+    std::pair<std::vector<int>, int> findPath(
+        int sourceId, int destinationId, bool isDriving,
+        const std::unordered_set<int>& blockedNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) override;
+    bool hasLocation(int id) const override { return graph.findLocation(id) != nullptr; }
+    const std::vector<int>& parkingLocations() override;
+    void reportMemory(MemoryReport& report) const override;
+    std::tuple<std::vector<int>, std::vector<int>, int, int, int, std::vector<Suggestion>> environmentallyFriendlyRoute(
+        int sourceId, int destId, int maxWalkingTime,
+        const std::unordered_set<int>& avoidNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& avoidSegments) override;
+
+private:
+    Graph& graph;
+    std::vector<int> parking;   ///< Filled on first use
+};
+
+/**
+ * @class SnapshotEngine
+ * @brief Dijkstra on the arrays of a GraphSnapshot, or A* when landmarks are available
+ * @complexity O((N + M) log N) per query; ALT usually settles far fewer locations.
+ */
+class SnapshotEngine : public SearchEngine {
+public:
+    /**
+     * @param snapshot The network to search.
+     * @param landmarks Landmark tables for the same snapshot, or nullptr for plain Dijkstra.
+     */
+    explicit SnapshotEngine(const GraphSnapshot& snapshot, const LandmarkIndex* landmarks = nullptr)
+        : snapshot(snapshot), landmarks(landmarks), search(snapshot) {}
+    const char* name() const override { return landmarks ? "alt" : "snapshot"; }
+    std::pair<std::vector<int>, int> findPath(
+        int sourceId, int destinationId, bool isDriving,
+        const std::unordered_set<int>& blockedNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) override;
+    bool hasLocation(int id) const override { return snapshot.indexOf(id) >= 0; }
+    const std::vector<int>& parkingLocations() override;
+    void reportMemory(MemoryReport& report) const override;
+
+private:
+    const GraphSnapshot& snapshot;
+    const LandmarkIndex* landmarks;
+    ArraySearch<GraphSnapshot> search;
+    std::vector<int> parking;   ///< Filled on first use
+};
+
+/**
+ * @class CompressedEngine
+ * @brief Dijkstra decoding the roads of a CompressedGraph on the fly
+ * @complexity O((N + M) log N) per query.
+ */
+class CompressedEngine : public SearchEngine {
+public:
+    explicit CompressedEngine(const CompressedGraph& graph) : graph(graph), search(graph) {}
+    const char* name() const override { return "compressed"; }
+    std::pair<std::vector<int>, int> findPath(
+        int sourceId, int destinationId, bool isDriving,
+        const std::unordered_set<int>& blockedNodes,
+        std::unordered_set<std::pair<int, int>, pair_hash>& blockedSegments) override;
+    bool hasLocation(int id) const override { return graph.indexOf(id) >= 0; }
+    const std::vector<int>& parkingLocations() override { return graph.parkingLocations(); }
+    void reportMemory(MemoryReport& report) const override;
+
+private:
+    const CompressedGraph& graph;
+    ArraySearch<CompressedGraph> search;
+};
+
+#endif // SEARCH_ENGINE_H
@@ -0,0 +1,53 @@
+/**
+* @file SearchStats.h
+ * @brief Per-query counters of the work done by the route searches
+ */
+
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <cstdint>
+
+/**
+ * @struct SearchStats
+ * @brief Work counters of the searches run on the calling thread
+ * @details The searches increment the counters of the calling thread through SEARCH_STAT.
+ * When the project is built without ROUTE_SEARCH_STATS the macro expands to nothing,
+ * so the searches carry no instrumentation and every counter stays zero.
+ */
+struct SearchStats {
+    uint64_t settled = 0;             ///< Locations popped and expanded
+    uint64_t relaxed = 0;             ///< Roads whose target distance was compared
+    uint64_t pushes = 0;              ///< Priority queue insertions
+    uint64_t pops = 0;                ///< Priority queue removals
+    uint64_t stalePops = 0;           ///< Removals of entries superseded by a shorter distance
+    uint64_t blockedSkips = 0;        ///< Avoided locations and roads skipped
+    uint64_t parkingCandidates = 0;   ///< Parking locations tried by driving-walking routes
+
+    /**
+     * @brief Counters of the calling thread.
+     */
+    static SearchStats& local() {
+        static thread_local SearchStats stats;
+        return stats;
+    }
+
+    /**
+     * @brief True if the searches were built with instrumentation.
+     */
+    static constexpr bool enabled() {
+#ifdef ROUTE_SEARCH_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+};
+
+#ifdef ROUTE_SEARCH_STATS
+#define SEARCH_STAT(counter) (++SearchStats::local().counter)
+#else
+#define SEARCH_STAT(counter) ((void)0)
+#endif
+
+#endif // SEARCH_STATS_H
@@ -0,0 +1,113 @@
+#include "Trace.h"
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::recording{false};
+
+namespace {
+
+/**
+ * @struct Span
+ * @brief One recorded span, times in nanoseconds since Trace::start()
+ */
+struct Span {
+    const char* name;
+    const char* key1;
+    const char* key2;
+    int64_t value1;
+    int64_t value2;
+    int64_t begin;
+    int64_t end;
+};
+
+/**
+ * @struct SpanBuffer
+ * @brief Ring buffer of one thread; grows up to the capacity, so short-lived threads stay small
+ */
+struct SpanBuffer {
+    std::vector<Span> spans;
+    size_t next = 0;        ///< Slot of the next span once the buffer is full
+    uint64_t recorded = 0;  ///< Spans ever recorded, including overwritten ones
+    int thread;             ///< tid in the exported trace
+};
+
+std::mutex registry;                                 ///< Guards buffers
+std::vector<std::unique_ptr<SpanBuffer>> buffers;    ///< One per recording thread, kept after it exits
+size_t capacity = Trace::DEFAULT_CAPACITY;
+std::chrono::steady_clock::time_point origin;
+
+SpanBuffer& localBuffer() {
+    static thread_local SpanBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(registry);
+        buffers.push_back(std::make_unique<SpanBuffer>());
+        buffer = buffers.back().get();
+        buffer->thread = static_cast<int>(buffers.size());
+    }
+    return *buffer;
+}
+
+void writeSpan(std::ostream& out, const Span& span, int thread) {
+    out << "{\"name\":\"" << span.name << "\",\"cat\":\"route\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+        << ",\"ts\":" << double(span.begin) / 1000.0 << ",\"dur\":" << double(span.end - span.begin) / 1000.0;
+    if (span.key1) {
+        out << ",\"args\":{\"" << span.key1 << "\":" << span.value1;
+        if (span.key2) out << ",\"" << span.key2 << "\":" << span.value2;
+        out << '}';
+    }
+    out << '}';
+}
+
+} // namespace
+
+void Trace::start(size_t spansPerThread) {
+    capacity = spansPerThread > 0 ? spansPerThread : 1;
+    origin = std::chrono::steady_clock::now();
+    recording.store(true, std::memory_order_relaxed);
+}
+
+int64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Trace::record(const char* name, int64_t begin, int64_t end,
+                   const char* key1, int64_t value1, const char* key2, int64_t value2) {
+    SpanBuffer& buffer = localBuffer();
+    Span span{name, key1, key2, value1, value2, begin, end};
+    if (buffer.spans.size() < capacity) {
+        buffer.spans.push_back(span);
+    } else {
+        buffer.spans[buffer.next] = span;
+        buffer.next = (buffer.next + 1) % capacity;
+    }
+    ++buffer.recorded;
+}
+
+bool Trace::write(const std::string& filename) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Error: Unable to open " << filename << std::endl;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(registry);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    uint64_t dropped = 0;
+    for (const auto& buffer : buffers) {
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread
+            << ",\"args\":{\"name\":\"thread " << buffer->thread << "\"}}";
+        first = false;
+        // Oldest first: a full ring starts at its next slot
+        for (size_t i = 0; i < buffer->spans.size(); ++i) {
+            out << ",\n";
+            writeSpan(out, buffer->spans[(buffer->next + i) % buffer->spans.size()], buffer->thread);
+        }
+        dropped += buffer->recorded - buffer->spans.size();
+    }
+    out << "\n]}\n";
+    if (dropped > 0) std::cerr << "Trace: " << dropped << " oldest spans overwritten" << std::endl;
+    return static_cast<bool>(out.flush());
+}
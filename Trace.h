@@ -0,0 +1,87 @@
+/**
+* @file Trace.h
+ * @brief Timeline of spans kept in per-thread ring buffers and exported as Chrome trace_event JSON
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class Trace
+ * @brief Process-wide switch and exporter of the recorded spans
+ * @details Each thread records into its own ring buffer, so recording takes no lock;
+ * when a buffer is full the oldest spans are overwritten. The file can be opened in
+ * chrome://tracing or Perfetto, with one row per thread.
+ */
+class Trace {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;   ///< Spans kept per thread
+
+    /**
+     * @brief Starts recording; spans begun before are ignored.
+     * @param capacity Number of spans kept per thread.
+     */
+    static void start(size_t capacity = DEFAULT_CAPACITY);
+
+    static bool enabled() { return recording.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Writes every recorded span as Chrome trace_event JSON.
+     * @details Must be called while no other thread is recording.
+     * @return False if the file could not be written.
+     * @complexity O(S) where S is the number of recorded spans.
+     */
+    static bool write(const std::string& filename);
+
+    /**
+     * @brief Nanoseconds since start().
+     */
+    static int64_t now();
+
+    /**
+     * @brief Adds one finished span to the calling thread's buffer.
+     */
+    static void record(const char* name, int64_t begin, int64_t end,
+                       const char* key1, int64_t value1, const char* key2, int64_t value2);
+
+private:
+    static std::atomic<bool> recording;
+};
+
+/**
+ * @class TraceSpan
+ * @brief Records the lifetime of a scope as a span, when tracing is enabled
+ * @details Name and argument keys must be string literals; they are stored as pointers.
+ * When tracing is off a span costs one relaxed load.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* key1 = nullptr, int64_t value1 = 0,
+                       const char* key2 = nullptr, int64_t value2 = 0)
+        : name(Trace::enabled() ? name : nullptr), key1(key1), key2(key2), value1(value1), value2(value2) {
+        if (this->name) begin = Trace::now();
+    }
+
+    ~TraceSpan() {
+        if (name) Trace::record(name, begin, Trace::now(), key1, value1, key2, value2);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;   ///< nullptr when not recording
+    const char* key1;
+    const char* key2;
+    int64_t value1;
+    int64_t value2;
+    int64_t begin = 0;
+};
+
+#endif // TRACE_H